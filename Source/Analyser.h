@@ -3,83 +3,306 @@
 
 //[Headers]     -- You can add your own extra header files here --
 #include <JuceHeader.h>
+#include "MultiResolutionSpectrum.h"
+#include "HalfBandDecimator.h"
+#include "Polyline.h"
+#include "TraceEvents.h"
+
+/** How the analyser splits the incoming channels into spectrum traces. */
+enum class AnalyserChannelMode
+{
+	Sum = 0,
+	LeftRight,
+	MidSide
+};
+
+/** Stereo image of the latest analysis frames, smoothed over time.
+	Width is the side share of the energy: 0 is mono, 0.5 is uncorrelated
+	and 1 is side only.
+*/
+struct StereoReadout
+{
+	static constexpr int numBands = 10;
+
+	bool valid = false;
+	bool hasBands = false;
+	float correlation = 1.0f;
+	std::array<float, numBands> width{};
+};
 
 template <typename Type>
 class Analyser : public juce::Thread
 {
 public:
 	//==============================================================================
+	static constexpr int fftOrder = 12;
+	static constexpr int fftSize = 1 << fftOrder;
+	static constexpr int spectrogramWidth = MultiResolutionSpectrum<Type>::numLogBins;
+
 	Analyser() : Thread("Spectrum Analyser")
 	{
-		mAvger.clear();
 	}
 
-	virtual ~Analyser() = default;
+	virtual ~Analyser()
+	{
+		stopAnalysis();
+	}
 
+	/** Audio thread entry point. Costs a single atomic check while the
+		analyser is stopped, so instances without an open editor do no work.
+	*/
 	void addAudioData(const juce::AudioBuffer<Type>& buffer, int startChannel, int numChannels)
 	{
-		if (mAbstractFifo.getFreeSpace() < buffer.getNumSamples())
-		{
+		// announce the write before checking mActive; stopAnalysis() does the
+		// reverse, so it either sees us here or we see it has stopped
+		mWriterActive.store(true);
+		if (mActive.load())
+			writeToFifo(buffer, startChannel, numChannels);
+		mWriterActive.store(false);
+	}
+
+	void setupAnalyser(int audioFifoSize, Type sampleRateToUse)
+	{
+		const juce::ScopedLock controlLock(mControlLock);
+		if (mWanted)
+			stopRunning();
+
+		mFifoSize = audioFifoSize;
+		mSampleRate = sampleRateToUse;
+
+		if (mWanted)
+			startRunning();
+	}
+
+	/** Allocates everything and starts the analysis thread. If the analyser
+		has not been set up yet it starts as soon as setupAnalyser() is called.
+	*/
+	void startAnalysis()
+	{
+		const juce::ScopedLock controlLock(mControlLock);
+		mWanted = true;
+		if (!mActive.load())
+			startRunning();
+	}
+
+	/** Stops the thread and releases all buffers. Safe against a concurrent
+		addAudioData() call: returns only once the audio thread is out of it.
+	*/
+	void stopAnalysis()
+	{
+		const juce::ScopedLock controlLock(mControlLock);
+		mWanted = false;
+		stopRunning();
+	}
+
+	bool isActive() const
+	{
+		return mActive.load();
+	}
+
+	/** 0 picks the factor from the sample rate, otherwise 1, 2 or 4, limited
+		to getMaxDecimation(). Applying a new factor restarts a running analyser.
+	*/
+	void setDecimation(int factor)
+	{
+		const juce::ScopedLock controlLock(mControlLock);
+		factor = factor == 2 || factor == 4 ? factor : juce::jlimit(0, 1, factor);
+		if (factor == mRequestedDecimation)
 			return;
-		}
-		int start1, size1, start2, size2;
-		mAbstractFifo.prepareToWrite(buffer.getNumSamples(), start1, size1, start2, size2);
-		mAudioFifo.copyFrom(0, start1, buffer.getReadPointer(startChannel), size1);
-		if (size2 > 0)
-			mAudioFifo.copyFrom(0, start2, buffer.getReadPointer(startChannel, size1), size2);
-		for (int channel = startChannel + 1; channel < startChannel + numChannels; ++channel)
+
+		mRequestedDecimation = factor;
+		if (mWanted)
 		{
-			if (size1 > 0)
-				mAudioFifo.addFrom(0, start1, buffer.getReadPointer(channel), size1);
-			if (size2 > 0)
-				mAudioFifo.addFrom(0, start2, buffer.getReadPointer(channel, size1), size2);
+			stopRunning();
+			startRunning();
 		}
-		mAbstractFifo.finishedWrite(size1 + size2);
-		mWaitData.signal();
+	}
 
+	int getDecimation() const
+	{
+		return mRequestedDecimation;
 	}
 
-	void setupAnalyser(int audioFifoSize, Type sampleRateToUse)
+	/** Largest factor that still leaves the analysis rate at 44.1 kHz or above,
+		the half-band filters' passband then covers the plot up to 20 kHz.
+	*/
+	static int getMaxDecimation(double sampleRate)
 	{
-		mSampleRate = sampleRateToUse;
-		mAudioFifo.setSize(1, audioFifoSize);
-		mAbstractFifo.setTotalSize(audioFifoSize);
+		int factor = 1;
+		while (sampleRate / (factor * 2) >= 44100.0 && factor < 4)
+			factor *= 2;
+		return factor;
+	}
 
-		startThread(5);
+	/** Number of audio blocks dropped because the analysis thread fell behind. */
+	int getNumDroppedBlocks() const
+	{
+		return mDroppedBlocks.load(std::memory_order_relaxed);
 	}
 
 	void run() override
 	{
 		while (!threadShouldExit())
 		{
-			if (mAbstractFifo.getNumReady() >= mFFT.getSize())
+			const bool multiResolution = mUseMultiResolution.load();
+			const auto channelMode = mChannelMode.load();
+			if (multiResolution != mRunningMultiResolution || channelMode != mRunningChannelMode)
 			{
+				juce::ScopedLock mLockedForWriting(mPathCreationLock);
+				for (auto& multiRes : mMultiResolution)
+					multiRes.reset();
+				for (auto& avger : mAvgers)
+					avger.clear();
+				for (auto& avger : mLogAvgers)
+					avger.clear();
+				mReadout = {};
+
+				// whatever is queued was written in the previous channel layout
+				mAbstractFifo.finishedRead(mAbstractFifo.getNumReady());
+
+				mRunningMultiResolution = multiResolution;
+				mRunningChannelMode = channelMode;
+			}
+
+			const int blockSize = multiResolution ? MultiRes::hopSize : fftSize;
+			const int numTraces = channelMode == AnalyserChannelMode::Sum ? 1 : 2;
+
+			if (mAbstractFifo.getNumReady() >= blockSize)
+			{
+				EQ_TRACE_SCOPE("Analyser frame");
 				mFFTbuffer.clear();
 
 				int start1, size1, start2, size2;
-				mAbstractFifo.prepareToRead(mFFT.getSize(), start1, size1, start2, size2);
-				if (size1 > 0)
-					mFFTbuffer.copyFrom(0, 0, mAudioFifo.getReadPointer(0, start1), size1);
-				if (size2 > 0)
-					mFFTbuffer.copyFrom(0, size1, mAudioFifo.getReadPointer(0, start2), size2);
-				mAbstractFifo.finishedRead((size1 + size2) / 2);
+				mAbstractFifo.prepareToRead(blockSize, start1, size1, start2, size2);
+				for (int channel = 0; channel < numTraces; ++channel)
+				{
+					if (size1 > 0)
+						mFFTbuffer.copyFrom(channel, 0, mAudioFifo.getReadPointer(channel, start1), size1);
+					if (size2 > 0)
+						mFFTbuffer.copyFrom(channel, size1, mAudioFifo.getReadPointer(channel, start2), size2);
+				}
 
-				mWindowing.multiplyWithWindowingTable(mFFTbuffer.getWritePointer(0), size_t(mFFT.getSize()));
-				mFFT.performFrequencyOnlyForwardTransform(mFFTbuffer.getWritePointer(0));
+				if (multiResolution)
+				{
+					mAbstractFifo.finishedRead(size1 + size2);
 
-				juce::ScopedLock mLockedForWriting(mPathCreationLock);
-				mAvger.addFrom(0, 0, mAvger.getReadPointer(mAvgerPtr), mAvger.getNumSamples(), -1.0f);
-				mAvger.copyFrom(mAvgerPtr, 0, mFFTbuffer.getReadPointer(0), mAvger.getNumSamples(),
-					1.0f / (mAvger.getNumSamples() * (mAvger.getNumChannels() - 1)));
-				mAvger.addFrom(0, 0, mAvger.getReadPointer(mAvgerPtr), mAvger.getNumSamples());
-				if (++mAvgerPtr == mAvger.getNumChannels())
-					mAvgerPtr = 1;
+					if (numTraces == 2)
+						processStereoHop(channelMode);
+
+					for (int trace = 0; trace < numTraces; ++trace)
+						mMultiResolution[size_t(trace)].processHop(mFFTbuffer.getReadPointer(trace));
+
+					pushSpectrogramRow(mMultiResolution[0].getSpectrum(), 1.0f, true);
+
+					EQ_TRACE_SCOPE("Analyser averaging");
+					juce::ScopedLock mLockedForWriting(mPathCreationLock);
+					for (int trace = 0; trace < numTraces; ++trace)
+						mLogAvgers[size_t(trace)].add(mMultiResolution[size_t(trace)].getSpectrum(), 1.0f / (Averager::numFrames));
+				}
+				else
+				{
+					mAbstractFifo.finishedRead((size1 + size2) / 2);
+
+					for (int channel = 0; channel < numTraces; ++channel)
+						mWindowing->multiplyWithWindowingTable(mFFTbuffer.getWritePointer(channel), size_t(fftSize));
+
+					if (numTraces == 2)
+						processStereoFrame(channelMode);
+					else
+						mFFT->performFrequencyOnlyForwardTransform(mFFTbuffer.getWritePointer(0));
+
+					pushSpectrogramRow(mFFTbuffer.getReadPointer(0), 2.0f / fftSize, false);
+
+					EQ_TRACE_SCOPE("Analyser averaging");
+					juce::ScopedLock mLockedForWriting(mPathCreationLock);
+					for (int trace = 0; trace < numTraces; ++trace)
+						mAvgers[size_t(trace)].add(mFFTbuffer.getReadPointer(trace),
+							1.0f / (mAvgers[size_t(trace)].getNumBins() * Averager::numFrames));
+				}
 
+				buildPaths(numTraces);
 				mNewDataAvailable = true;
 			}
-			if (mAbstractFifo.getNumReady() < mFFT.getSize())
+			if (mAbstractFifo.getNumReady() < blockSize)
 				mWaitData.wait(100);
 		}
+
+		// the analyser is restarted on every prepareToPlay
+		TraceEvents::releaseThread();
+	}
+
+	/** Switches between the single 4096 point FFT and the multi-resolution
+		cascade, which trades a little CPU for much finer low-frequency bins.
+	*/
+	void setMultiResolution(bool shouldUseMultiResolution)
+	{
+		mUseMultiResolution = shouldUseMultiResolution;
+	}
+
+	bool isMultiResolution() const
+	{
+		return mUseMultiResolution.load();
+	}
+
+	void setChannelMode(AnalyserChannelMode mode)
+	{
+		mChannelMode = mode;
+	}
+
+	AnalyserChannelMode getChannelMode() const
+	{
+		return mChannelMode.load();
+	}
+
+	/** Number of spectrum traces createPath can draw for the current mode. */
+	int getNumTraces()
+	{
+		juce::ScopedLock lockedforReading(mPathCreationLock);
+		if (!mAllocated)
+			return 0;
+		return mRunningChannelMode == AnalyserChannelMode::Sum ? 1 : 2;
+	}
+
+	StereoReadout getStereoReadout()
+	{
+		juce::ScopedLock lockedforReading(mPathCreationLock);
+		return mReadout;
+	}
+
+	/** Only produce spectrogram rows while somebody is drawing them. */
+	void setSpectrogramEnabled(bool shouldBeEnabled)
+	{
+		mSpectrogramEnabled = shouldBeEnabled;
+	}
+
+	bool isSpectrogramEnabled() const
+	{
+		return mSpectrogramEnabled.load();
+	}
+
+	/** Pops up to maxRows pending spectrogram rows of spectrogramWidth bytes
+		each, oldest first. Lock-free, for a single reader such as the GL thread.
+	*/
+	int readSpectrogramRows(juce::uint8* dest, int maxRows)
+	{
+		// same handshake as addAudioData(): stopRunning() waits for us before it frees the rows
+		mSpectrogramReaderActive.store(true);
+		int numRead = 0;
+
+		if (mSpectrogramAvailable.load())
+		{
+			int start1, size1, start2, size2;
+			mSpectrogramFifo.prepareToRead(maxRows, start1, size1, start2, size2);
+			if (size1 > 0)
+				std::copy_n(mSpectrogramRows.data() + start1 * spectrogramWidth, size1 * spectrogramWidth, dest);
+			if (size2 > 0)
+				std::copy_n(mSpectrogramRows.data() + start2 * spectrogramWidth, size2 * spectrogramWidth, dest + size1 * spectrogramWidth);
+			mSpectrogramFifo.finishedRead(size1 + size2);
+			numRead = size1 + size2;
+		}
+
+		mSpectrogramReaderActive.store(false);
+		return numRead;
 	}
 
 	bool checkDataAvailable()
@@ -89,13 +312,63 @@ public:
 		return available;
 	}
 
-	void createPath(juce::Path& p, const juce::Rectangle<float> bounds, float minFreq)
+	void createPath(juce::Path& p, const juce::Rectangle<float> bounds, float minFreq, int trace = 0)
 	{
-		p.clear();
-		p.preallocateSpace(8 + mAvger.getNumSamples() * 20);
-		
+		// the scope includes waiting for mPathCreationLock
+		EQ_TRACE_SCOPE("Analyser createPath");
 		juce::ScopedLock lockedforReading(mPathCreationLock);
-		const auto* fftData = mAvger.getReadPointer(0);
+		if (!mAllocated)
+		{
+			p.clear();
+			return;
+		}
+
+		buildPath(p, trace, bounds, minFreq);
+	}
+
+	/** Sets the bounds the analysis thread builds its paths for after every frame. */
+	void setPlotBounds(const juce::Rectangle<float> bounds, float minFreq)
+	{
+		const juce::SpinLock::ScopedLockType geometryLock(mGeometryLock);
+		mPlotBounds = bounds;
+		mPlotMinFreq = minFreq;
+		mPathReady.fill(false);
+	}
+
+	/** Swaps the path prebuilt by the analysis thread into p, and its flattened
+		points into points. Returns false and leaves both alone if no new path
+		for the current bounds is ready yet.
+	*/
+	bool swapPath(juce::Path& p, Polyline::Points& points, int trace = 0)
+	{
+		const juce::SpinLock::ScopedLockType geometryLock(mGeometryLock);
+		if (!juce::isPositiveAndBelow(trace, int(mReadyPaths.size())) || !mPathReady[size_t(trace)])
+			return false;
+
+		p.swapWithPath(mReadyPaths[size_t(trace)]);
+		std::swap(points, mReadyPoints[size_t(trace)]);
+		mPathReady[size_t(trace)] = false;
+		return true;
+	}
+
+private:
+	using MultiRes = MultiResolutionSpectrum<Type>;
+
+	void buildPath(juce::Path& p, int trace, const juce::Rectangle<float> bounds, float minFreq)
+	{
+		p.clear();
+		p.preallocateSpace(8 + fftSize / 2 * 20);
+
+		trace = juce::jlimit(0, (mRunningChannelMode == AnalyserChannelMode::Sum ? 0 : 1), trace);
+
+		if (mRunningMultiResolution)
+		{
+			createLogPath(p, mLogAvgers[size_t(trace)], bounds, minFreq);
+			return;
+		}
+
+		const auto& avger = mAvgers[size_t(trace)];
+		const auto* fftData = avger.getData();
 		const auto factor = bounds.getWidth() / 10.0f;
 		
 		p.startNewSubPath(0, bounds.getHeight());
@@ -107,7 +380,7 @@ public:
 				bounds.getX() + factor * indexToX(i + 2, minFreq), binToY(fftData[i + 2], bounds),
 				bounds.getX() + factor * indexToX(i +4, minFreq), binToY(fftData[i+ 4], bounds));
 		}
-		for (int i = 90; i <= mAvger.getNumSamples(); i += 12) {
+		for (int i = 90; i <= avger.getNumBins(); i += 12) {
 			p.cubicTo(bounds.getX() + factor * indexToX(i, minFreq), binToY(fftData[i], bounds),
 				bounds.getX() + factor * indexToX(i + 4, minFreq), binToY(fftData[i + 4], bounds),
 				bounds.getX() + factor * indexToX(i + 8, minFreq), binToY(fftData[i + 8], bounds));
@@ -117,11 +390,473 @@ public:
 		p.closeSubPath();
 	}
 
-private:
+	/** Runs on the analysis thread right after the averagers were updated, so
+		paint only has to swap the finished paths and their points in. The
+		averagers are only written by this thread, so reading them here needs
+		no lock.
+	*/
+	void buildPaths(int numTraces)
+	{
+		EQ_TRACE_SCOPE("Analyser buildPaths");
+		juce::Rectangle<float> bounds;
+		float minFreq;
+		{
+			const juce::SpinLock::ScopedLockType geometryLock(mGeometryLock);
+			bounds = mPlotBounds;
+			minFreq = mPlotMinFreq;
+		}
+
+		if (bounds.isEmpty())
+			return;
+
+		for (int trace = 0; trace < numTraces; ++trace)
+		{
+			auto& path = mBuildPaths[size_t(trace)];
+			auto& points = mBuildPoints[size_t(trace)];
+			buildPath(path, trace, bounds, minFreq);
+			Polyline::fromPath(path, points);
+
+			const juce::SpinLock::ScopedLockType geometryLock(mGeometryLock);
+			if (bounds != mPlotBounds)
+				return;
+
+			path.swapWithPath(mReadyPaths[size_t(trace)]);
+			std::swap(points, mReadyPoints[size_t(trace)]);
+			mPathReady[size_t(trace)] = true;
+		}
+	}
+
+	void writeToFifo(const juce::AudioBuffer<Type>& buffer, int startChannel, int numChannels)
+	{
+		const auto channelMode = mChannelMode.load();
+		if (channelMode != mWritingChannelMode)
+		{
+			// Sum only feeds channel 0's decimators, so channel 1's would be out of phase
+			for (auto& channel : mDecimators)
+				for (auto& decimator : channel)
+					decimator.reset();
+
+			mDecimationPhase = 0;
+			mWritingChannelMode = channelMode;
+		}
+
+		const auto numSamples = buffer.getNumSamples();
+		const auto numOut = (mDecimationPhase + numSamples) / mDecimation;
+
+		if (mAbstractFifo.getFreeSpace() < numOut)
+		{
+			mDroppedBlocks.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		int start1, size1, start2, size2;
+		mAbstractFifo.prepareToWrite(numOut, start1, size1, start2, size2);
+
+		numChannels = juce::jmin(numChannels, maxSourceChannels);
+		const Type* sources[maxSourceChannels];
+		for (int channel = 0; channel < numChannels; ++channel)
+			sources[channel] = buffer.getReadPointer(startChannel + channel);
+
+		if (channelMode == AnalyserChannelMode::Sum)
+		{
+			writeChannel(0, sources, numChannels, numSamples, start1, size1, start2, size2);
+		}
+		else
+		{
+			// mono sources are duplicated so the stereo maths stays valid
+			for (int channel = 0; channel < mAudioFifo.getNumChannels(); ++channel)
+				writeChannel(channel, sources + juce::jmin(channel, numChannels - 1), 1, numSamples, start1, size1, start2, size2);
+		}
+
+		mDecimationPhase = (mDecimationPhase + numSamples) % mDecimation;
+		mAbstractFifo.finishedWrite(size1 + size2);
+		mWaitData.signal();
+	}
+
+	/** Downmixes the sources straight into one FIFO channel. Without decimation
+		that is a single vectorised add per region; with it the sum goes through
+		a small stack chunk and one half-band lowpass per halving, so nothing
+		above the analysis Nyquist folds back into the plot.
+	*/
+	void writeChannel(int fifoChannel, const Type* const* sources, int numSources, int numSamples,
+		int start1, int size1, int start2, int size2)
+	{
+		auto* dest1 = mAudioFifo.getWritePointer(fifoChannel, start1);
+		auto* dest2 = mAudioFifo.getWritePointer(fifoChannel, start2);
+
+		if (mDecimation == 1)
+		{
+			sumInto(dest1, sources, numSources, 0, size1);
+			sumInto(dest2, sources, numSources, size1, size2);
+			return;
+		}
+
+		constexpr int chunkSize = 256;
+		Type chunk[chunkSize];
+
+		auto& decimators = mDecimators[size_t(fifoChannel)];
+		const auto numStages = mDecimation == 4 ? 2 : 1;
+		int written = 0;
+
+		for (int pos = 0; pos < numSamples; pos += chunkSize)
+		{
+			const auto num = juce::jmin(chunkSize, numSamples - pos);
+			sumInto(chunk, sources, numSources, pos, num);
+
+			for (int i = 0; i < num; ++i)
+			{
+				auto sample = chunk[i];
+				int stage = 0;
+				while (stage < numStages && decimators[size_t(stage)].push(sample, sample))
+					++stage;
+
+				if (stage == numStages)
+				{
+					(written < size1 ? dest1[written] : dest2[written - size1]) = sample;
+					++written;
+				}
+			}
+		}
+	}
+
+	static void sumInto(Type* dest, const Type* const* sources, int numSources, int offset, int num)
+	{
+		if (num <= 0)
+			return;
+
+		if (numSources == 1)
+		{
+			juce::FloatVectorOperations::copy(dest, sources[0] + offset, num);
+			return;
+		}
+
+		juce::FloatVectorOperations::add(dest, sources[0] + offset, sources[1] + offset, num);
+		for (int channel = 2; channel < numSources; ++channel)
+			juce::FloatVectorOperations::add(dest, sources[channel] + offset, num);
+	}
+
+	void startRunning()
+	{
+		if (mFifoSize <= 0 || mSampleRate <= 0)
+			return;
+
+		// the plot stops at 20 kHz, so at high sample rates everything above
+		// ~24 kHz can be dropped before it costs FIFO space and FFT time; a
+		// requested factor is only applied as far as it keeps the whole plot
+		const auto maxDecimation = getMaxDecimation(double(mSampleRate));
+		mDecimation = mRequestedDecimation > 0 ? juce::jmin(mRequestedDecimation, maxDecimation) : maxDecimation;
+
+		mAnalysisRate = mSampleRate / Type(mDecimation);
+		mDecimationPhase = 0;
+		mWritingChannelMode = mChannelMode.load();
+
+		if (mDecimation > 1)
+		{
+			// passband to 0.225 of the input rate, so 19.8 kHz even when 88.2 kHz is halved
+			auto halfBand = juce::dsp::FilterDesign<Type>::designFIRLowpassHalfBandEquirippleMethod(Type(0.05), Type(-70));
+			for (auto& channel : mDecimators)
+				for (auto& decimator : channel)
+					decimator.setCoefficients(halfBand->getRawCoefficients(), int(halfBand->getFilterOrder()) + 1);
+		}
+
+		{
+			juce::ScopedLock mLockedForWriting(mPathCreationLock);
+
+			mFFT = std::make_unique<juce::dsp::FFT>(fftOrder);
+			mWindowing = std::make_unique<juce::dsp::WindowingFunction<Type>>(size_t(fftSize), juce::dsp::WindowingFunction<Type>::hann, true);
+			mFFTbuffer.setSize(2, fftSize * 2);
+			mCrossSpectra.setSize(3, fftSize);
+
+			for (auto& avger : mAvgers)
+				avger.setSize(fftSize / 2);
+			for (auto& avger : mLogAvgers)
+				avger.setSize(MultiRes::numLogBins);
+			for (auto& multiRes : mMultiResolution)
+				multiRes.prepare(mAnalysisRate);
+
+			mAudioFifo.setSize(2, mFifoSize / mDecimation);
+			mAbstractFifo.setTotalSize(mFifoSize / mDecimation);
+			mAbstractFifo.reset();
+
+			mSpectrogramRows.resize(size_t(mSpectrogramFifo.getTotalSize()) * spectrogramWidth);
+			mSpectrogramFifo.reset();
+
+			const auto binWidth = float(mAnalysisRate) / float(fftSize);
+			for (int column = 0; column < spectrogramWidth; ++column)
+			{
+				auto& range = mSpectrogramBins[size_t(column)];
+				range.first = juce::jlimit(0, fftSize / 2 - 1, int(MultiRes::getBinFrequency(column - 0.5f) / binWidth));
+				range.second = juce::jlimit(range.first, fftSize / 2 - 1, int(MultiRes::getBinFrequency(column + 0.5f) / binWidth));
+			}
+
+			mReadout = {};
+			mAllocated = true;
+		}
+
+		mSpectrogramAvailable.store(true);
+		startThread(5);
+		mActive.store(true);
+	}
+
+	void stopRunning()
+	{
+		mActive.store(false);
+		while (mWriterActive.load())
+			juce::Thread::yield();
+
+		mSpectrogramAvailable.store(false);
+		while (mSpectrogramReaderActive.load())
+			juce::Thread::yield();
+
+		stopThread(1000);
+
+		juce::ScopedLock mLockedForWriting(mPathCreationLock);
+		mAllocated = false;
+
+		mFFT.reset();
+		mWindowing.reset();
+		mFFTbuffer = juce::AudioBuffer<float>();
+		mCrossSpectra = juce::AudioBuffer<float>();
+		mAudioFifo = juce::AudioBuffer<Type>();
+		mSpectrogramRows = {};
+
+		for (auto& avger : mAvgers)
+			avger.release();
+		for (auto& avger : mLogAvgers)
+			avger.release();
+		for (auto& multiRes : mMultiResolution)
+			multiRes.release();
+		for (auto& channel : mDecimators)
+			for (auto& decimator : channel)
+				decimator.release();
+
+		const juce::SpinLock::ScopedLockType geometryLock(mGeometryLock);
+		mBuildPaths.fill(juce::Path());
+		mReadyPaths.fill(juce::Path());
+		mBuildPoints.fill({});
+		mReadyPoints.fill({});
+		mPathReady.fill(false);
+	}
+
+
+	/** Running average over the last numFrames frames; row 0 holds the sum. */
+	struct Averager
+	{
+		static constexpr int numFrames = 4;
+
+		void setSize(int numBins)
+		{
+			buffer.setSize(numFrames + 1, numBins);
+			clear();
+		}
+
+		void clear()
+		{
+			buffer.clear();
+			ptr = 1;
+		}
+
+		void release()
+		{
+			buffer = juce::AudioBuffer<float>();
+			ptr = 1;
+		}
+
+		void add(const float* frame, float gain)
+		{
+			buffer.addFrom(0, 0, buffer.getReadPointer(ptr), buffer.getNumSamples(), -1.0f);
+			buffer.copyFrom(ptr, 0, frame, buffer.getNumSamples(), gain);
+			buffer.addFrom(0, 0, buffer.getReadPointer(ptr), buffer.getNumSamples());
+			if (++ptr == buffer.getNumChannels())
+				ptr = 1;
+		}
+
+		const float* getData() const { return buffer.getReadPointer(0); }
+		int getNumBins() const { return buffer.getNumSamples(); }
+
+		juce::AudioBuffer<float> buffer;
+		int ptr = 1;
+	};
+
+	/** Turns the two windowed channels in mFFTbuffer into the magnitude
+		spectra of the requested traces and updates the stereo readout.
+		The cross and auto spectra are plain element-wise products of the
+		interleaved real FFT output, so they run as vector multiplies; only
+		the re/im pair reduction is scalar.
+	*/
+	void processStereoFrame(AnalyserChannelMode channelMode)
+	{
+		const int numBins = fftSize / 2;
+		const int numFloats = numBins * 2;
+
+		auto* left = mFFTbuffer.getWritePointer(0);
+		auto* right = mFFTbuffer.getWritePointer(1);
+		mFFT->performRealOnlyForwardTransform(left, true);
+		mFFT->performRealOnlyForwardTransform(right, true);
+
+		auto* ll = mCrossSpectra.getWritePointer(0);
+		auto* rr = mCrossSpectra.getWritePointer(1);
+		auto* lr = mCrossSpectra.getWritePointer(2);
+		juce::FloatVectorOperations::multiply(ll, left, left, numFloats);
+		juce::FloatVectorOperations::multiply(rr, right, right, numFloats);
+		juce::FloatVectorOperations::multiply(lr, left, right, numFloats);
+
+		// re*re + im*im per bin; index i never overtakes 2i so this works in place
+		for (int i = 0; i < numBins; ++i)
+		{
+			ll[i] = ll[2 * i] + ll[2 * i + 1];
+			rr[i] = rr[2 * i] + rr[2 * i + 1];
+			lr[i] = lr[2 * i] + lr[2 * i + 1];
+		}
+
+		if (channelMode == AnalyserChannelMode::MidSide)
+		{
+			for (int i = 0; i < numBins; ++i)
+			{
+				left[i] = 0.5f * std::sqrt(juce::jmax(0.0f, ll[i] + rr[i] + 2.0f * lr[i]));
+				right[i] = 0.5f * std::sqrt(juce::jmax(0.0f, ll[i] + rr[i] - 2.0f * lr[i]));
+			}
+		}
+		else
+		{
+			for (int i = 0; i < numBins; ++i)
+			{
+				left[i] = std::sqrt(ll[i]);
+				right[i] = std::sqrt(rr[i]);
+			}
+		}
+
+		StereoReadout frame;
+		frame.hasBands = true;
+		frame.correlation = getCorrelation(sumRange(ll, 1, numBins), sumRange(rr, 1, numBins), sumRange(lr, 1, numBins));
+
+		const auto binWidth = float(mAnalysisRate) / float(fftSize);
+		for (int band = 0; band < StereoReadout::numBands; ++band)
+		{
+			const auto first = juce::jlimit(1, numBins, int(20.0f * float(1 << band) / binWidth));
+			const auto last = juce::jlimit(first, numBins, int(20.0f * float(2 << band) / binWidth) + 1);
+			frame.width[size_t(band)] = getWidth(sumRange(ll, first, last), sumRange(rr, first, last), sumRange(lr, first, last));
+		}
+
+		updateReadout(frame);
+	}
+
+	/** Multi-resolution counterpart of processStereoFrame: the cascade works on
+		time-domain signals, so the traces are formed before the FFT and only
+		the broadband correlation is available.
+	*/
+	void processStereoHop(AnalyserChannelMode channelMode)
+	{
+		const int numSamples = MultiRes::hopSize;
+		auto* left = mFFTbuffer.getWritePointer(0);
+		auto* right = mFFTbuffer.getWritePointer(1);
+
+		auto* products = mCrossSpectra.getWritePointer(0);
+		juce::FloatVectorOperations::multiply(products, left, left, numSamples);
+		const auto ll = sumRange(products, 0, numSamples);
+		juce::FloatVectorOperations::multiply(products, right, right, numSamples);
+		const auto rr = sumRange(products, 0, numSamples);
+		juce::FloatVectorOperations::multiply(products, left, right, numSamples);
+		const auto lr = sumRange(products, 0, numSamples);
+
+		StereoReadout frame;
+		frame.correlation = getCorrelation(ll, rr, lr);
+		updateReadout(frame);
+
+		if (channelMode == AnalyserChannelMode::MidSide)
+		{
+			auto* side = mCrossSpectra.getWritePointer(1);
+			juce::FloatVectorOperations::subtract(side, left, right, numSamples);
+			juce::FloatVectorOperations::add(left, right, numSamples);
+			juce::FloatVectorOperations::copyWithMultiply(right, side, 0.5f, numSamples);
+			juce::FloatVectorOperations::multiply(left, 0.5f, numSamples);
+		}
+	}
+
+	void updateReadout(const StereoReadout& frame)
+	{
+		juce::ScopedLock mLockedForWriting(mPathCreationLock);
+		const auto smoothing = mReadout.valid ? 0.3f : 1.0f;
+
+		mReadout.correlation += smoothing * (frame.correlation - mReadout.correlation);
+		for (size_t band = 0; band < mReadout.width.size(); ++band)
+			mReadout.width[band] += smoothing * (frame.width[band] - mReadout.width[band]);
+
+		mReadout.hasBands = frame.hasBands;
+		mReadout.valid = true;
+	}
+
+	/** Maps one magnitude frame to a log-frequency row of bytes, 0 at -120 dB
+		and 255 at +30 dB, the same range the analyser plot uses.
+	*/
+	void pushSpectrogramRow(const float* magnitudes, float gain, bool logBins)
+	{
+		if (!mSpectrogramEnabled.load() || mSpectrogramFifo.getFreeSpace() < 1)
+			return;
+
+		int start1, size1, start2, size2;
+		mSpectrogramFifo.prepareToWrite(1, start1, size1, start2, size2);
+		auto* row = mSpectrogramRows.data() + start1 * spectrogramWidth;
+
+		for (int column = 0; column < spectrogramWidth; ++column)
+		{
+			float magnitude;
+			if (logBins)
+			{
+				magnitude = magnitudes[column];
+			}
+			else
+			{
+				const auto& range = mSpectrogramBins[size_t(column)];
+				magnitude = juce::FloatVectorOperations::findMaximum(magnitudes + range.first, range.second - range.first + 1);
+			}
+
+			const auto level = juce::jmap(juce::Decibels::gainToDecibels(magnitude * gain, -120.0f), -120.0f, 30.0f, 0.0f, 255.0f);
+			row[column] = juce::uint8(juce::jlimit(0.0f, 255.0f, level));
+		}
+
+		mSpectrogramFifo.finishedWrite(size1);
+	}
+
+	static float sumRange(const float* data, int first, int last)
+	{
+		float sum = 0.0f;
+		for (int i = first; i < last; ++i)
+			sum += data[i];
+		return sum;
+	}
+
+	static float getCorrelation(float ll, float rr, float lr)
+	{
+		const auto energy = std::sqrt(ll * rr);
+		return energy > 1.0e-12f ? juce::jlimit(-1.0f, 1.0f, lr / energy) : 1.0f;
+	}
+
+	static float getWidth(float ll, float rr, float lr)
+	{
+		// |S|^2 / (|M|^2 + |S|^2) with M = (L + R) / 2 and S = (L - R) / 2
+		const auto energy = ll + rr;
+		return energy > 1.0e-12f ? juce::jlimit(0.0f, 1.0f, (energy - 2.0f * lr) / (2.0f * energy)) : 0.0f;
+	}
+
+	void createLogPath(juce::Path& p, const Averager& avger, const juce::Rectangle<float> bounds, float minFreq)
+	{
+		const auto* logData = avger.getData();
+		const auto factor = bounds.getWidth() / 10.0f;
+
+		p.startNewSubPath(0, bounds.getHeight());
+		for (int i = 0; i < avger.getNumBins(); ++i)
+		{
+			const auto x = std::log(MultiRes::getBinFrequency(float(i)) / minFreq) / std::log(2.0f);
+			p.lineTo(bounds.getX() + factor * x, binToY(logData[i], bounds));
+		}
+		p.lineTo(bounds.getWidth(), bounds.getHeight());
+
+		p.closeSubPath();
+	}
 
 	inline float indexToX(float index, float minFreq) const
 	{
-		const auto freq = (mSampleRate * index) / mFFT.getSize();
+		const auto freq = (mAnalysisRate * index) / fftSize;
 		return (freq > 0.01f) ? std::log(freq / minFreq) / std::log(2.0f) : 0.0f;
 	}
 
@@ -131,14 +866,29 @@ private:
 		return juce::jmap(juce::Decibels::gainToDecibels(bin, infinity), infinity, 30.0f, bounds.getBottom(), bounds.getY()); 
 	}
 
-	juce::dsp::FFT mFFT{ 12 };
-	juce::AudioBuffer<float> mFFTbuffer{ 1, mFFT.getSize() * 2 };
-	juce::dsp::WindowingFunction<Type> mWindowing{ size_t(mFFT.getSize()), juce::dsp::WindowingFunction<Type>::hann, true };
+	std::unique_ptr<juce::dsp::FFT> mFFT;
+	juce::AudioBuffer<float> mFFTbuffer;
+	juce::AudioBuffer<float> mCrossSpectra;
+	std::unique_ptr<juce::dsp::WindowingFunction<Type>> mWindowing;
 
 	juce::WindowedSincInterpolator mInterpolator;
 
-	juce::AudioBuffer<float> mAvger{ 5, mFFT.getSize() / 2 };
-	int mAvgerPtr = 1;
+	std::array<Averager, 2> mAvgers;
+
+	std::array<MultiRes, 2> mMultiResolution;
+	std::array<Averager, 2> mLogAvgers;
+
+	std::atomic<bool> mUseMultiResolution{ false };
+	bool mRunningMultiResolution = false;
+
+	std::atomic<AnalyserChannelMode> mChannelMode{ AnalyserChannelMode::Sum };
+	AnalyserChannelMode mRunningChannelMode = AnalyserChannelMode::Sum;
+	StereoReadout mReadout;
+
+	juce::AbstractFifo mSpectrogramFifo{ 64 };
+	std::vector<juce::uint8> mSpectrogramRows;
+	std::array<std::pair<int, int>, spectrogramWidth> mSpectrogramBins;
+	std::atomic<bool> mSpectrogramEnabled{ false };
 
 	//==============================================================================
 	juce::AbstractFifo mAbstractFifo{ 48000 };
@@ -148,6 +898,37 @@ private:
 
 	std::atomic<bool> mNewDataAvailable;
 	Type mSampleRate{};
+	Type mAnalysisRate{};
+	int mFifoSize = 0;
+
+	static constexpr int maxSourceChannels = 8;
+	int mRequestedDecimation = 0;
+	int mDecimation = 1;
+	int mDecimationPhase = 0;
+	AnalyserChannelMode mWritingChannelMode = AnalyserChannelMode::Sum; // audio thread only while running
+	std::array<std::array<HalfBandDecimator<Type>, 2>, 2> mDecimators; // [FIFO channel][halving]
+	std::atomic<int> mDroppedBlocks{ 0 };
+
+	juce::SpinLock mGeometryLock;
+	juce::Rectangle<float> mPlotBounds;
+	float mPlotMinFreq = 20.0f;
+	std::array<juce::Path, 2> mBuildPaths;
+	std::array<juce::Path, 2> mReadyPaths;
+	std::array<Polyline::Points, 2> mBuildPoints;
+	std::array<Polyline::Points, 2> mReadyPoints;
+	std::array<bool, 2> mPathReady{};
+
+	// mActive gates the audio thread, mWriterActive tells stopRunning() it is
+	// still inside addAudioData(). Start/stop/setup are serialised by mControlLock,
+	// which the audio thread never touches.
+	std::atomic<bool> mActive{ false };
+	std::atomic<bool> mWriterActive{ false };
+	// the same pair for the spectrogram rows and readSpectrogramRows()
+	std::atomic<bool> mSpectrogramAvailable{ false };
+	std::atomic<bool> mSpectrogramReaderActive{ false };
+	bool mWanted = false;
+	bool mAllocated = false;
+	juce::CriticalSection mControlLock;
 
 	juce::CriticalSection mPathCreationLock;
 	//==============================================================================
@@ -58,6 +58,8 @@ public:
 	void buttonClicked(juce::Button* b) override;
 
 	juce::Path bFrequencyResponse;
+	Polyline::Points bFrequencyPoints;
+	Polyline::Points bPreviousFrequencyPoints;
 
 	//==============================================================================
 	//[UserMethods]     -- You can add your own custom methods in this section.
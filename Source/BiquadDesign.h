@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    BiquadDesign.h
+
+    The filter designs of juce::dsp::IIR::Coefficients, computed the same way
+    in float but returned by value instead of in a newly allocated object, so
+    they can run on the audio thread when the host automates there. First
+    order designs come back as biquads with zero second order terms. The
+    golden command checks them against JUCE's own factories.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct BiquadDesign
+{
+	/** b0, b1, b2, a1, a2, normalised to a0 == 1. */
+	using Coefficients = std::array<float, 5>;
+
+	static Coefficients identity()
+	{
+		return { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	}
+
+	static Coefficients lowPass(double sampleRate, float frequency, float quality)
+	{
+		const auto n = 1 / std::tan(pi * frequency / float(sampleRate));
+		const auto nSquared = n * n;
+		const auto invQ = 1 / quality;
+		const auto c1 = 1 / (1 + invQ * n + nSquared);
+
+		return normalise(c1, c1 * 2, c1, 1, c1 * 2 * (1 - nSquared), c1 * (1 - invQ * n + nSquared));
+	}
+
+	static Coefficients highPass(double sampleRate, float frequency, float quality)
+	{
+		const auto n = std::tan(pi * frequency / float(sampleRate));
+		const auto nSquared = n * n;
+		const auto invQ = 1 / quality;
+		const auto c1 = 1 / (1 + invQ * n + nSquared);
+
+		return normalise(c1, c1 * -2, c1, 1, c1 * 2 * (nSquared - 1), c1 * (1 - invQ * n + nSquared));
+	}
+
+	static Coefficients bandPass(double sampleRate, float frequency, float quality)
+	{
+		const auto n = 1 / std::tan(pi * frequency / float(sampleRate));
+		const auto nSquared = n * n;
+		const auto invQ = 1 / quality;
+		const auto c1 = 1 / (1 + invQ * n + nSquared);
+
+		return normalise(c1 * n * invQ, 0, -c1 * n * invQ, 1, c1 * 2 * (1 - nSquared), c1 * (1 - invQ * n + nSquared));
+	}
+
+	static Coefficients notch(double sampleRate, float frequency, float quality)
+	{
+		const auto n = 1 / std::tan(pi * frequency / float(sampleRate));
+		const auto nSquared = n * n;
+		const auto invQ = 1 / quality;
+		const auto c1 = 1 / (1 + n * invQ + nSquared);
+		const auto b0 = c1 * (1 + nSquared);
+		const auto b1 = 2 * c1 * (1 - nSquared);
+
+		return normalise(b0, b1, b0, 1, b1, c1 * (1 - n * invQ + nSquared));
+	}
+
+	static Coefficients allPass(double sampleRate, float frequency, float quality)
+	{
+		const auto n = 1 / std::tan(pi * frequency / float(sampleRate));
+		const auto nSquared = n * n;
+		const auto invQ = 1 / quality;
+		const auto c1 = 1 / (1 + invQ * n + nSquared);
+		const auto b0 = c1 * (1 - n * invQ + nSquared);
+		const auto b1 = c1 * 2 * (1 - nSquared);
+
+		return normalise(b0, b1, 1, 1, b1, b0);
+	}
+
+	static Coefficients firstOrderLowPass(double sampleRate, float frequency)
+	{
+		const auto n = std::tan(pi * frequency / float(sampleRate));
+		return normalise(n, n, 0, n + 1, n - 1, 0);
+	}
+
+	static Coefficients firstOrderHighPass(double sampleRate, float frequency)
+	{
+		const auto n = std::tan(pi * frequency / float(sampleRate));
+		return normalise(1, -1, 0, n + 1, n - 1, 0);
+	}
+
+	static Coefficients firstOrderAllPass(double sampleRate, float frequency)
+	{
+		const auto n = std::tan(pi * frequency / float(sampleRate));
+		return normalise(n - 1, n + 1, 0, n + 1, n - 1, 0);
+	}
+
+	static Coefficients lowShelf(double sampleRate, float frequency, float quality, float gainFactor)
+	{
+		const auto A = juce::jmax(0.0f, std::sqrt(gainFactor));
+		const auto aminus1 = A - 1;
+		const auto aplus1 = A + 1;
+		const auto omega = (2 * pi * juce::jmax(frequency, 2.0f)) / float(sampleRate);
+		const auto coso = std::cos(omega);
+		const auto beta = std::sin(omega) * std::sqrt(A) / quality;
+		const auto aminus1TimesCoso = aminus1 * coso;
+
+		return normalise(A * (aplus1 - aminus1TimesCoso + beta),
+			A * 2 * (aminus1 - aplus1 * coso),
+			A * (aplus1 - aminus1TimesCoso - beta),
+			aplus1 + aminus1TimesCoso + beta,
+			-2 * (aminus1 + aplus1 * coso),
+			aplus1 + aminus1TimesCoso - beta);
+	}
+
+	static Coefficients highShelf(double sampleRate, float frequency, float quality, float gainFactor)
+	{
+		const auto A = juce::jmax(0.0f, std::sqrt(gainFactor));
+		const auto aminus1 = A - 1;
+		const auto aplus1 = A + 1;
+		const auto omega = (2 * pi * juce::jmax(frequency, 2.0f)) / float(sampleRate);
+		const auto coso = std::cos(omega);
+		const auto beta = std::sin(omega) * std::sqrt(A) / quality;
+		const auto aminus1TimesCoso = aminus1 * coso;
+
+		return normalise(A * (aplus1 + aminus1TimesCoso + beta),
+			A * -2 * (aminus1 + aplus1 * coso),
+			A * (aplus1 + aminus1TimesCoso - beta),
+			aplus1 - aminus1TimesCoso + beta,
+			2 * (aminus1 - aplus1 * coso),
+			aplus1 - aminus1TimesCoso - beta);
+	}
+
+	static Coefficients peak(double sampleRate, float frequency, float quality, float gainFactor)
+	{
+		const auto A = juce::jmax(0.0f, std::sqrt(gainFactor));
+		const auto omega = (2 * pi * juce::jmax(frequency, 2.0f)) / float(sampleRate);
+		const auto alpha = std::sin(omega) / (quality * 2);
+		const auto c2 = -2 * std::cos(omega);
+		const auto alphaTimesA = alpha * A;
+		const auto alphaOverA = alpha / A;
+
+		return normalise(1 + alphaTimesA, c2, 1 - alphaTimesA, 1 + alphaOverA, c2, 1 - alphaOverA);
+	}
+
+private:
+	static constexpr float pi = juce::MathConstants<float>::pi;
+
+	/** Same arithmetic as the Coefficients constructors. */
+	static Coefficients normalise(float b0, float b1, float b2, float a0, float a1, float a2)
+	{
+		const auto a0inv = a0 != 0 ? 1 / a0 : 0.0f;
+		return { b0 * a0inv, b1 * a0inv, b2 * a0inv, a1 * a0inv, a2 * a0inv };
+	}
+};
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    CrossfadeRamp.h
+
+    A linear mix between an "off" and an "on" signal that moves towards its
+    target over a fixed number of samples. Once it has arrived callers can
+    skip the mixing altogether, so a settled band or bypass costs nothing
+    extra. Linear rather than equal power, because both sides are the same
+    signal with or without a filter and sum coherently.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class CrossfadeRamp
+{
+public:
+	CrossfadeRamp() = default;
+
+	/** Changes the fade length, a running fade keeps how far through it is. */
+	void setLength(int numSamples)
+	{
+		numSamples = juce::jmax(1, numSamples);
+		if (numSamples != mLength)
+		{
+			mPosition = int(juce::int64(mPosition) * numSamples / mLength);
+			mLength = numSamples;
+		}
+	}
+
+	void setTarget(bool shouldBeOn)
+	{
+		mTarget = shouldBeOn;
+	}
+
+	/** Jumps to the target without fading. */
+	void skip()
+	{
+		mPosition = mTarget ? mLength : 0;
+	}
+
+	bool isOn() const { return mTarget && mPosition == mLength; }
+	bool isOff() const { return !mTarget && mPosition == 0; }
+
+	/** True while nothing of the "on" signal has been heard yet. */
+	bool isSilent() const { return mPosition == 0; }
+
+	/** Writes the mix for the next numSamples samples, 0 is off and 1 is on. */
+	void getNextGains(float* gains, int numSamples)
+	{
+		const auto step = mTarget ? 1 : -1;
+		const auto scale = 1.0f / float(mLength);
+
+		for (int i = 0; i < numSamples; ++i)
+		{
+			mPosition = juce::jlimit(0, mLength, mPosition + step);
+			gains[i] = float(mPosition) * scale;
+		}
+	}
+
+	/** dest = off + gains * (on - off), dest may be either of the two. */
+	static void mix(juce::dsp::AudioBlock<float>& dest, const juce::dsp::AudioBlock<float>& off,
+		const juce::dsp::AudioBlock<float>& on, const float* gains)
+	{
+		for (size_t channel = 0; channel < dest.getNumChannels(); ++channel)
+		{
+			auto* out = dest.getChannelPointer(channel);
+			const auto* offData = off.getChannelPointer(channel);
+			const auto* onData = on.getChannelPointer(channel);
+
+			for (size_t i = 0; i < dest.getNumSamples(); ++i)
+				out[i] = offData[i] + gains[i] * (onData[i] - offData[i]);
+		}
+	}
+
+private:
+	int mLength = 1;
+	int mPosition = 0;
+	bool mTarget = false;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CrossfadeRamp)
+};
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    CurveRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "CurveRenderer.h"
+
+#ifdef JUCE_OPENGL
+
+#if JUCE_VERSION >= 0x60100
+using namespace juce::gl;
+#endif
+
+// positions arrive in component pixels with y down, the shader does the flip
+static const char* curveVertexShader =
+    "attribute vec2 position;\n"
+    "uniform vec2 viewSize;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(position.x / viewSize.x * 2.0 - 1.0, 1.0 - position.y / viewSize.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* curveFragmentShader =
+    "uniform " JUCE_MEDIUMP " vec4 colour;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = colour;\n"
+    "}\n";
+
+CurveRenderer::~CurveRenderer()
+{
+    // release() has to run on the GL thread before the context goes away
+    jassert(mVertexBuffer == 0 && mShader == nullptr);
+}
+
+void CurveRenderer::create(juce::OpenGLContext& context)
+{
+    mShader = std::make_unique<juce::OpenGLShaderProgram>(context);
+
+    if (!mShader->addVertexShader(juce::OpenGLHelpers::translateVertexShaderToV3(curveVertexShader))
+        || !mShader->addFragmentShader(juce::OpenGLHelpers::translateFragmentShaderToV3(curveFragmentShader))
+        || !mShader->link())
+    {
+        DBG("Curve shader failed: " << mShader->getLastError());
+        mShader.reset();
+        return;
+    }
+
+    mViewSize = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*mShader, "viewSize");
+    mColour = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*mShader, "colour");
+    mPosition = std::make_unique<juce::OpenGLShaderProgram::Attribute>(*mShader, "position");
+
+    context.extensions.glGenBuffers(1, &mVertexBuffer);
+    mReady = true;
+}
+
+void CurveRenderer::release(juce::OpenGLContext& context)
+{
+    mReady = false;
+
+    if (mVertexBuffer != 0)
+    {
+        context.extensions.glDeleteBuffers(1, &mVertexBuffer);
+        mVertexBuffer = 0;
+    }
+
+    mPosition.reset();
+    mColour.reset();
+    mViewSize.reset();
+    mShader.reset();
+}
+
+void CurveRenderer::setCurves(std::vector<Curve>& curves, size_t numCurves)
+{
+    jassert(numCurves <= curves.size());
+
+    const juce::SpinLock::ScopedLockType curveLock(mCurveLock);
+    std::swap(mPending, curves);
+    mNumPending = juce::jmin(numCurves, mPending.size());
+    mHasPending = true;
+}
+
+void CurveRenderer::appendStroke(const Curve& curve, float scale)
+{
+    const auto& points = curve.points;
+    const auto numPoints = points.size();
+    if (numPoints < 2 || curve.strokeColour.isTransparent())
+        return;
+
+    // a strip thinner than a physical pixel would drop in and out between
+    // samples, so it stays one pixel wide and gives up opacity instead, the
+    // way the software renderer's coverage does
+    const auto minWidth = 1.0f / scale;
+    const auto halfWidth = 0.5f * juce::jmax(minWidth, curve.strokeWidth);
+    const auto colour = curve.strokeWidth < minWidth
+        ? curve.strokeColour.withMultipliedAlpha(curve.strokeWidth / minWidth) : curve.strokeColour;
+    const auto first = int(mVertices.size() / 2);
+    juce::Point<float> normal{ 0.0f, halfWidth };
+
+    for (size_t i = 0; i < numPoints; ++i)
+    {
+        // the tangent across both neighbours keeps the joins smooth without miters
+        const auto tangent = points[juce::jmin(i + 1, numPoints - 1)] - points[i > 0 ? i - 1 : 0];
+        const auto length = tangent.getDistanceFromOrigin();
+        if (length > 1.0e-4f)
+            normal = { -tangent.y * halfWidth / length, tangent.x * halfWidth / length };
+
+        mVertices.insert(mVertices.end(), { points[i].x + normal.x, points[i].y + normal.y,
+                                            points[i].x - normal.x, points[i].y - normal.y });
+    }
+
+    mRanges.push_back({ colour, first, int(numPoints) * 2 });
+}
+
+void CurveRenderer::appendFill(const Curve& curve)
+{
+    const auto& points = curve.points;
+    if (points.size() < 2 || curve.fillColour.isTransparent())
+        return;
+
+    const auto first = int(mVertices.size() / 2);
+    for (const auto& point : points)
+        mVertices.insert(mVertices.end(), { point.x, point.y, point.x, curve.fillBaseline });
+
+    mRanges.push_back({ curve.fillColour, first, int(points.size()) * 2 });
+}
+
+void CurveRenderer::render(juce::OpenGLContext& context, juce::Point<int> componentSize, float scale, juce::Rectangle<int> clip)
+{
+    if (mShader == nullptr || componentSize.x <= 0 || componentSize.y <= 0)
+        return;
+
+    {
+        const juce::SpinLock::ScopedLockType curveLock(mCurveLock);
+        if (mHasPending)
+        {
+            std::swap(mDrawing, mPending);
+            mNumDrawing = mNumPending;
+            mHasPending = false;
+        }
+    }
+
+    // fills first so every stroke ends up on top of them
+    mVertices.clear();
+    mRanges.clear();
+    for (size_t i = 0; i < mNumDrawing; ++i)
+        appendFill(mDrawing[i]);
+    for (size_t i = 0; i < mNumDrawing; ++i)
+        appendStroke(mDrawing[i], scale);
+
+    if (mRanges.empty())
+        return;
+
+    glViewport(0, 0, juce::roundToInt(componentSize.x * scale), juce::roundToInt(componentSize.y * scale));
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(clip.getX(), clip.getY(), clip.getWidth(), clip.getHeight());
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    mShader->use();
+    mViewSize->set(float(componentSize.x), float(componentSize.y));
+
+    context.extensions.glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    context.extensions.glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(mVertices.size() * sizeof(GLfloat)), mVertices.data(), GL_STREAM_DRAW);
+    context.extensions.glVertexAttribPointer(GLuint(mPosition->attributeID), 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    context.extensions.glEnableVertexAttribArray(GLuint(mPosition->attributeID));
+
+    for (const auto& range : mRanges)
+    {
+        mColour->set(range.colour.getFloatRed(), range.colour.getFloatGreen(), range.colour.getFloatBlue(), range.colour.getFloatAlpha());
+        glDrawArrays(GL_TRIANGLE_STRIP, range.first, range.count);
+    }
+
+    context.extensions.glDisableVertexAttribArray(GLuint(mPosition->attributeID));
+    context.extensions.glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+#endif // JUCE_OPENGL
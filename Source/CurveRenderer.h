@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    CurveRenderer.h
+
+    Draws the analyser traces and response curves with OpenGL. Curves are
+    handed over as polylines; strokes are extruded to triangle strips and
+    fills are strips down to a baseline, all uploaded into one vertex buffer
+    per frame and drawn with a flat colour shader. The context is expected
+    to multisample, which is what smooths the strip edges.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Polyline.h"
+
+#ifdef JUCE_OPENGL
+
+class CurveRenderer
+{
+public:
+	//==============================================================================
+	struct Curve
+	{
+		Polyline::Points points;
+		juce::Colour strokeColour;
+		float strokeWidth = 1.0f;
+		juce::Colour fillColour = juce::Colours::transparentBlack;
+		float fillBaseline = 0.0f;
+	};
+
+	CurveRenderer() = default;
+	~CurveRenderer();
+
+	/** Must be called on the GL thread, from newOpenGLContextCreated(). */
+	void create(juce::OpenGLContext& context);
+
+	/** Must be called on the GL thread, from openGLContextClosing(). */
+	void release(juce::OpenGLContext& context);
+
+	/** True once the shader compiled, so the software fallback can be skipped. */
+	bool isReady() const { return mReady.load(); }
+
+	/** Hands the first numCurves curves over for the next frame. The vector is
+		swapped with the previous frame's and never resized, so the caller can
+		keep slots beyond numCurves, and their point storage, for later frames.
+	*/
+	void setCurves(std::vector<Curve>& curves, size_t numCurves);
+
+	/** Draws the latest curves. Coordinates are in component pixels; clip is
+		the plot area in physical GL pixels.
+	*/
+	void render(juce::OpenGLContext& context, juce::Point<int> componentSize, float scale, juce::Rectangle<int> clip);
+
+private:
+	//==============================================================================
+	void appendStroke(const Curve& curve, float scale);
+	void appendFill(const Curve& curve);
+
+	std::unique_ptr<juce::OpenGLShaderProgram> mShader;
+	std::unique_ptr<juce::OpenGLShaderProgram::Uniform> mViewSize;
+	std::unique_ptr<juce::OpenGLShaderProgram::Uniform> mColour;
+	std::unique_ptr<juce::OpenGLShaderProgram::Attribute> mPosition;
+
+	GLuint mVertexBuffer = 0;
+	std::atomic<bool> mReady{ false };
+
+	juce::SpinLock mCurveLock;
+	std::vector<Curve> mPending;
+	std::vector<Curve> mDrawing;
+	size_t mNumPending = 0;
+	size_t mNumDrawing = 0;
+	bool mHasPending = false;
+
+	struct Range
+	{
+		juce::Colour colour;
+		int first = 0;
+		int count = 0;
+	};
+	std::vector<GLfloat> mVertices;
+	std::vector<Range> mRanges;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CurveRenderer)
+};
+
+#endif // JUCE_OPENGL
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    FramePacer.h
+
+    Drives the editor's animation frames. Frames follow the display's vertical
+    blank where JUCE provides it and a 60 Hz timer otherwise, drop to a few
+    frames per second while the editor is hidden or minimised, and skip vblanks
+    when painting or the message thread can't keep up.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class FramePacer : private juce::Timer
+{
+public:
+	//==============================================================================
+	static constexpr int fallbackRateHz = 60;
+	static constexpr int idleRateHz = 4;
+	static constexpr int maxDivider = 8;
+
+	FramePacer(juce::Component& componentToPace, std::function<void()> frameCallback)
+		: mComponent(componentToPace), mOnFrame(std::move(frameCallback))
+	{
+	}
+
+	~FramePacer() override
+	{
+		stop();
+	}
+
+	void start()
+	{
+		mLastTick = juce::Time::getMillisecondCounterHiRes();
+#if JUCE_VERSION >= 0x70000
+		mVBlank = std::make_unique<juce::VBlankAttachment>(&mComponent, [this] { tick(); });
+#else
+		startTimerHz(fallbackRateHz);
+#endif
+	}
+
+	void stop()
+	{
+#if JUCE_VERSION >= 0x70000
+		mVBlank.reset();
+#endif
+		stopTimer();
+	}
+
+	/** Reports how long the last paint took, so the rate can back off under load. */
+	void reportPaintTime(double milliseconds)
+	{
+		mPaintTime += 0.1 * (milliseconds - mPaintTime);
+	}
+
+	/** Number of display frames per rendered frame, 1 while keeping up. */
+	int getDivider() const { return mDivider; }
+
+private:
+	//==============================================================================
+	void timerCallback() override
+	{
+		tick();
+	}
+
+	bool isIdle() const
+	{
+		if (!mComponent.isShowing())
+			return true;
+
+		auto* peer = mComponent.getPeer();
+		return peer == nullptr || peer->isMinimised();
+	}
+
+	void tick()
+	{
+		const auto now = juce::Time::getMillisecondCounterHiRes();
+		const auto interval = now - mLastTick;
+		mLastTick = now;
+
+		if (isIdle())
+		{
+			// hidden editors still poll slowly so they notice when they come back
+			if (now - mLastFrame < 1000.0 / idleRateHz)
+				return;
+
+			mLastFrame = now;
+			mOnFrame();
+			return;
+		}
+
+		// a tick arriving much later than the display interval means the message
+		// thread is saturated, e.g. by many open editors, so count it as load too
+		mFrameInterval += 0.1 * (juce::jlimit(1.0, 100.0, interval) - mFrameInterval);
+		mLate = mLate || interval > 2.0 * mExpectedInterval;
+
+		if (++mSkipped < mDivider)
+			return;
+
+		const auto load = mPaintTime / (mFrameInterval * mDivider) + (mLate ? 0.5 : 0.0);
+		if (load > 0.5 && mDivider < maxDivider)
+			++mDivider;
+		else if (load < 0.15 && mDivider > 1)
+			--mDivider;
+
+		mSkipped = 0;
+		mLate = false;
+		mLastFrame = now;
+		mOnFrame();
+	}
+
+	//==============================================================================
+	juce::Component& mComponent;
+	std::function<void()> mOnFrame;
+
+#if JUCE_VERSION >= 0x70000
+	std::unique_ptr<juce::VBlankAttachment> mVBlank;
+#endif
+
+	const double mExpectedInterval = 1000.0 / fallbackRateHz;
+	double mFrameInterval = 1000.0 / fallbackRateHz;
+	double mPaintTime = 0;
+	double mLastTick = 0;
+	double mLastFrame = 0;
+	int mDivider = 1;
+	int mSkipped = 0;
+	bool mLate = false;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FramePacer)
+};
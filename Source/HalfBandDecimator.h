@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    HalfBandDecimator.h
+
+    Halves the sample rate through a half-band FIR lowpass. Every second tap
+    of a half-band filter is zero apart from the centre one, so only the
+    non-zero taps are kept and each output costs about half the filter length.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename Type>
+class HalfBandDecimator
+{
+public:
+	HalfBandDecimator() = default;
+
+	/** Allocates, call from a thread that may. */
+	void setCoefficients(const Type* coefficients, int numTaps)
+	{
+		mTaps.clear();
+		mCoefficients.clear();
+		for (int i = 0; i < numTaps; ++i)
+		{
+			if (coefficients[i] != Type(0))
+			{
+				mTaps.push_back(size_t(i));
+				mCoefficients.push_back(coefficients[i]);
+			}
+		}
+
+		mNumTaps = size_t(numTaps);
+		mState.assign(mNumTaps * 2, Type(0));
+		reset();
+	}
+
+	void release()
+	{
+		mTaps = {};
+		mCoefficients = {};
+		mState = {};
+		mNumTaps = 0;
+		mPos = 0;
+	}
+
+	void reset()
+	{
+		std::fill(mState.begin(), mState.end(), Type(0));
+		mPos = 0;
+		mPhase = false;
+	}
+
+	/** Returns true every second sample, when output holds a new decimated value. */
+	bool push(Type input, Type& output)
+	{
+		// the state is written twice so the dot product never has to wrap
+		mState[mPos] = input;
+		mState[mPos + mNumTaps] = input;
+		mPos = (mPos == 0 ? mNumTaps : mPos) - 1;
+
+		mPhase = !mPhase;
+		if (mPhase)
+			return false;
+
+		const auto* x = mState.data() + mPos + 1;
+		Type sum = 0;
+		for (size_t i = 0; i < mTaps.size(); ++i)
+			sum += mCoefficients[i] * x[mTaps[i]];
+
+		output = sum;
+		return true;
+	}
+
+private:
+	std::vector<size_t> mTaps;
+	std::vector<Type> mCoefficients;
+	std::vector<Type> mState;
+	size_t mNumTaps = 0;
+	size_t mPos = 0;
+	bool mPhase = false;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HalfBandDecimator)
+};
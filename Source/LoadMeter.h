@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    LoadMeter.h
+
+    Times every processBlock call against its real-time budget of
+    numSamples / sampleRate and keeps a histogram of the resulting load in
+    1% steps. The audio thread only does relaxed atomic increments; any
+    other thread can read percentiles, the maximum and the overrun count,
+    or dump the whole histogram.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class LoadMeter
+{
+public:
+	//==============================================================================
+	/** Buckets are 1% wide, the last one also collects everything above 200%. */
+	static constexpr int numBuckets = 201;
+
+	struct Snapshot
+	{
+		juce::int64 numBlocks = 0;
+		juce::int64 numOverruns = 0;
+		float current = 0.0f;
+		float p50 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+	};
+
+	/** Measures from construction to destruction, put one at the top of processBlock. */
+	class ScopedMeasurement
+	{
+	public:
+		ScopedMeasurement(LoadMeter& meterToUse, int numSamplesToMeasure)
+			: meter(meterToUse), numSamples(numSamplesToMeasure), start(juce::Time::getHighResolutionTicks())
+		{
+		}
+
+		~ScopedMeasurement()
+		{
+			meter.addBlock(numSamples, juce::Time::getHighResolutionTicks() - start);
+		}
+
+	private:
+		LoadMeter& meter;
+		const int numSamples;
+		const juce::int64 start;
+
+		JUCE_DECLARE_NON_COPYABLE(ScopedMeasurement)
+	};
+
+	LoadMeter() = default;
+
+	void prepare(double sampleRate)
+	{
+		mTicksPerSample.store(sampleRate > 0 ? double(juce::Time::getHighResolutionTicksPerSecond()) / sampleRate : 0.0);
+		mSecondsPerSample.store(sampleRate > 0 ? 1.0 / sampleRate : 0.0);
+	}
+
+	/** Called on the audio thread. */
+	void addBlock(int numSamples, juce::int64 elapsedTicks)
+	{
+		const auto budget = double(numSamples) * mTicksPerSample.load(std::memory_order_relaxed);
+		if (budget <= 0)
+			return;
+
+		const auto load = float(double(elapsedTicks) / budget);
+
+		mBuckets[size_t(juce::jlimit(0, numBuckets - 1, int(load * 100.0f)))].fetch_add(1, std::memory_order_relaxed);
+
+		if (load > 1.0f)
+			mNumOverruns.fetch_add(1, std::memory_order_relaxed);
+
+		// the audio thread is the only writer, so no compare-exchange is needed
+		if (load > mMax.load(std::memory_order_relaxed))
+			mMax.store(load, std::memory_order_relaxed);
+		if (load > mRecentPeak.load(std::memory_order_relaxed))
+			mRecentPeak.store(load, std::memory_order_relaxed);
+
+		// smoothed over roughly 300 ms whatever the block size
+		const auto weight = float(juce::jmin(1.0, numSamples * mSecondsPerSample.load(std::memory_order_relaxed) / 0.3));
+		const auto current = mCurrent.load(std::memory_order_relaxed);
+		mCurrent.store(current + weight * (load - current), std::memory_order_relaxed);
+	}
+
+	Snapshot getSnapshot() const
+	{
+		std::array<juce::int64, numBuckets> counts;
+		juce::int64 total = 0;
+		for (size_t i = 0; i < counts.size(); ++i)
+			total += (counts[i] = mBuckets[i].load(std::memory_order_relaxed));
+
+		Snapshot snapshot;
+		snapshot.numBlocks = total;
+		snapshot.numOverruns = mNumOverruns.load(std::memory_order_relaxed);
+		snapshot.current = mCurrent.load(std::memory_order_relaxed);
+		snapshot.max = mMax.load(std::memory_order_relaxed);
+		// bucket edges can overshoot the true maximum, which is known exactly
+		snapshot.p50 = juce::jmin(snapshot.max, getPercentile(counts, total, 0.50));
+		snapshot.p99 = juce::jmin(snapshot.max, getPercentile(counts, total, 0.99));
+		return snapshot;
+	}
+
+	/** Highest load since the last call, so a meter polled at a few Hz still sees short spikes. */
+	float takeRecentPeak()
+	{
+		return mRecentPeak.exchange(0.0f, std::memory_order_relaxed);
+	}
+
+	/** Counts from blocks running concurrently with a reset may land on either side of it. */
+	void reset()
+	{
+		for (auto& bucket : mBuckets)
+			bucket.store(0, std::memory_order_relaxed);
+
+		mNumOverruns.store(0, std::memory_order_relaxed);
+		mMax.store(0.0f, std::memory_order_relaxed);
+		mRecentPeak.store(0.0f, std::memory_order_relaxed);
+	}
+
+	/** The full histogram as text, for debugging. */
+	juce::String getReport() const
+	{
+		const auto snapshot = getSnapshot();
+
+		juce::String report;
+		report << "DSP load over " << snapshot.numBlocks << " blocks: p50 " << juce::roundToInt(snapshot.p50 * 100.0f)
+			<< "%, p99 " << juce::roundToInt(snapshot.p99 * 100.0f) << "%, max " << juce::roundToInt(snapshot.max * 100.0f)
+			<< "%, " << snapshot.numOverruns << " over budget" << juce::newLine;
+
+		for (int i = 0; i < numBuckets; ++i)
+		{
+			const auto count = mBuckets[size_t(i)].load(std::memory_order_relaxed);
+			if (count == 0)
+				continue;
+
+			if (i + 1 < numBuckets)
+				report << juce::String(i).paddedLeft(' ', 3) << "-" << (i + 1) << "%\t" << count << juce::newLine;
+			else
+				report << ">=" << i << "%\t" << count << juce::newLine;
+		}
+
+		return report;
+	}
+
+private:
+	//==============================================================================
+	/** Upper edge of the bucket the given fraction of blocks falls into. */
+	static float getPercentile(const std::array<juce::int64, numBuckets>& counts, juce::int64 total, double fraction)
+	{
+		if (total == 0)
+			return 0.0f;
+
+		const auto target = juce::int64(std::ceil(fraction * double(total)));
+		juce::int64 sum = 0;
+		for (size_t i = 0; i < counts.size(); ++i)
+		{
+			sum += counts[i];
+			if (sum >= target)
+				return float(i + 1) / 100.0f;
+		}
+
+		return float(numBuckets) / 100.0f;
+	}
+
+	std::array<std::atomic<juce::int64>, numBuckets> mBuckets{};
+	std::atomic<juce::int64> mNumOverruns{ 0 };
+	std::atomic<float> mMax{ 0.0f };
+	std::atomic<float> mRecentPeak{ 0.0f };
+	std::atomic<float> mCurrent{ 0.0f };
+
+	std::atomic<double> mTicksPerSample{ 0.0 };
+	std::atomic<double> mSecondsPerSample{ 0.0 };
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadMeter)
+};
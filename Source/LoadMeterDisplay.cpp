@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    LoadMeterDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "LoadMeterDisplay.h"
+
+static int toPercent(float load)
+{
+    return juce::roundToInt(load * 100.0f);
+}
+
+LoadMeterDisplay::LoadMeterDisplay(LoadMeter& meterToShow) : mMeter(meterToShow)
+{
+    setOpaque(false);
+}
+
+void LoadMeterDisplay::update()
+{
+    const auto snapshot = mMeter.getSnapshot();
+    const auto peak = mMeter.takeRecentPeak();
+
+    auto text = "DSP " + juce::String(toPercent(snapshot.current)) + "%";
+    if (snapshot.numOverruns > 0)
+        text << "  " << snapshot.numOverruns << " over";
+
+    const auto changed = text != mText || toPercent(peak) != toPercent(mPeak) || toPercent(snapshot.current) != toPercent(mSnapshot.current);
+
+    mSnapshot = snapshot;
+    mPeak = peak;
+    mText = text;
+
+    if (!changed)
+        return;
+
+    setTooltip("Share of the real-time budget used by processBlock\n"
+        "p50 " + juce::String(toPercent(snapshot.p50)) + "%, p99 " + juce::String(toPercent(snapshot.p99))
+        + "%, max " + juce::String(toPercent(snapshot.max)) + "%\n"
+        + juce::String(snapshot.numOverruns) + " of " + juce::String(snapshot.numBlocks) + " blocks over budget\n"
+        "Double-click to reset");
+    repaint();
+}
+
+void LoadMeterDisplay::paint(juce::Graphics& g)
+{
+    const auto bounds = getLocalBounds().toFloat();
+    const auto colour = mSnapshot.current < 0.5f ? juce::Colours::limegreen
+                      : mSnapshot.current < 0.8f ? juce::Colours::orange
+                                                 : juce::Colours::red;
+
+    g.setColour(juce::Colours::black.withAlpha(0.4f));
+    g.fillRoundedRectangle(bounds, 3.0f);
+
+    g.setColour(colour.withAlpha(0.6f));
+    g.fillRoundedRectangle(bounds.withWidth(bounds.getWidth() * juce::jlimit(0.0f, 1.0f, mSnapshot.current)), 3.0f);
+
+    if (mPeak > 0.0f)
+    {
+        g.setColour(mPeak > 1.0f ? juce::Colours::red : juce::Colours::silver);
+        g.drawVerticalLine(juce::roundToInt(bounds.getX() + bounds.getWidth() * juce::jmin(1.0f, mPeak)) - 1, bounds.getY(), bounds.getBottom());
+    }
+
+    g.setColour(juce::Colours::silver);
+    g.setFont(11.0f);
+    g.drawFittedText(mText, getLocalBounds().reduced(4, 0), juce::Justification::centredLeft, 1);
+}
+
+void LoadMeterDisplay::mouseDoubleClick(const juce::MouseEvent& event)
+{
+    juce::ignoreUnused(event);
+
+    mMeter.reset();
+    mText.clear();
+    update();
+}
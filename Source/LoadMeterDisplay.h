@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    LoadMeterDisplay.h
+
+    Small bar showing how much of its real-time budget processBlock uses,
+    with the recent peak as a tick and the histogram summary as tooltip.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LoadMeter.h"
+
+class LoadMeterDisplay : public juce::Component,
+	public juce::SettableTooltipClient
+{
+public:
+	//==============================================================================
+	explicit LoadMeterDisplay(LoadMeter& meterToShow);
+
+	/** Polls the meter, repainting only if what is shown changed. Called a few times a second. */
+	void update();
+
+	void paint(juce::Graphics& g) override;
+
+	/** Double-clicking starts the statistics afresh. */
+	void mouseDoubleClick(const juce::MouseEvent& event) override;
+
+private:
+	//==============================================================================
+	LoadMeter& mMeter;
+	LoadMeter::Snapshot mSnapshot;
+	float mPeak = 0.0f;
+	juce::String mText;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadMeterDisplay)
+};
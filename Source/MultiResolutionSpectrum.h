@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    MultiResolutionSpectrum.h
+
+    Runs a cascade of small FFTs on successively half-band decimated copies
+    of the input and stitches them into one log-frequency spectrum, so the
+    low octaves get the bin resolution of a much larger FFT.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HalfBandDecimator.h"
+
+template <typename Type>
+class MultiResolutionSpectrum
+{
+public:
+	//==============================================================================
+	static constexpr int numStages = 4;
+	static constexpr int fftOrder = 11;
+	static constexpr int fftSize = 1 << fftOrder;
+	static constexpr int hopSize = fftSize / 2;
+	static constexpr int numLogBins = 512;
+
+	MultiResolutionSpectrum()
+	{
+		mSpectrum.resize(numLogBins, 0.0f);
+	}
+
+	void prepare(Type sampleRateToUse)
+	{
+		mSampleRate = sampleRateToUse;
+
+		mFFT = std::make_unique<juce::dsp::FFT>(fftOrder);
+		mWindowing = std::make_unique<juce::dsp::WindowingFunction<float>>(size_t(fftSize), juce::dsp::WindowingFunction<float>::hann, true);
+		mFFTData.setSize(1, fftSize * 2);
+
+		// transition band is relative to the input rate of each stage, so the
+		// passband of every decimated stage ends at 0.4 of its own sample rate
+		auto halfBand = juce::dsp::FilterDesign<Type>::designFIRLowpassHalfBandEquirippleMethod(Type(0.05), Type(-70));
+
+		for (auto& stage : mStages)
+		{
+			stage.decimator.setCoefficients(halfBand->getRawCoefficients(), int(halfBand->getFilterOrder()) + 1);
+			stage.history.assign(size_t(fftSize), 0.0f);
+			stage.magnitudes.assign(size_t(fftSize / 2 + 1), 0.0f);
+		}
+
+		for (int bin = 0; bin < numLogBins; ++bin)
+		{
+			auto& map = mBinMap[size_t(bin)];
+			const auto freq = getBinFrequency(float(bin));
+
+			map.stage = 0;
+			for (int k = numStages - 1; k > 0; --k)
+			{
+				if (freq < 0.4f * float(mSampleRate) / float(1 << k))
+				{
+					map.stage = k;
+					break;
+				}
+			}
+
+			const auto binWidth = float(mSampleRate) / float(1 << map.stage) / float(fftSize);
+			const auto maxBin = float(fftSize / 2);
+			map.centre = juce::jlimit(0.0f, maxBin, freq / binWidth);
+			map.low = juce::jlimit(0, fftSize / 2, int(std::floor(getBinFrequency(bin - 0.5f) / binWidth)));
+			map.high = juce::jlimit(0, fftSize / 2, int(std::ceil(getBinFrequency(bin + 0.5f) / binWidth)));
+		}
+
+		reset();
+	}
+
+	/** Frees the FFT engine and all buffers until the next prepare(). */
+	void release()
+	{
+		mFFT.reset();
+		mWindowing.reset();
+		mFFTData = juce::AudioBuffer<float>();
+
+		for (auto& stage : mStages)
+		{
+			stage.decimator.release();
+			stage.history = {};
+			stage.magnitudes = {};
+		}
+	}
+
+	void reset()
+	{
+		for (auto& stage : mStages)
+		{
+			stage.decimator.reset();
+			std::fill(stage.history.begin(), stage.history.end(), 0.0f);
+			std::fill(stage.magnitudes.begin(), stage.magnitudes.end(), 0.0f);
+			stage.writePos = 0;
+			stage.sinceLastFrame = 0;
+		}
+		std::fill(mSpectrum.begin(), mSpectrum.end(), 0.0f);
+	}
+
+	/** Feeds one hop of samples through the cascade and refreshes the stitched
+		spectrum. Stage k runs its FFT once every 2^k hops.
+	*/
+	void processHop(const Type* samples)
+	{
+		for (int i = 0; i < hopSize; ++i)
+			pushSample(samples[i]);
+
+		stitch();
+	}
+
+	const float* getSpectrum() const { return mSpectrum.data(); }
+
+	/** Log-spaced bin centres cover the same 10 octaves from 20 Hz as the plot. */
+	static float getBinFrequency(float bin)
+	{
+		return 20.0f * std::pow(2.0f, 10.0f * bin / float(numLogBins - 1));
+	}
+
+private:
+	//==============================================================================
+	struct Stage
+	{
+		HalfBandDecimator<Type> decimator;
+		std::vector<float> history;
+		std::vector<float> magnitudes;
+		int writePos = 0;
+		int sinceLastFrame = 0;
+	};
+
+	struct BinMap
+	{
+		int stage = 0;
+		float centre = 0.0f;
+		int low = 0;
+		int high = 0;
+	};
+
+	void pushSample(Type sample)
+	{
+		auto x = sample;
+		for (size_t k = 0; k < mStages.size(); ++k)
+		{
+			auto& stage = mStages[k];
+			if (k > 0 && !stage.decimator.push(x, x))
+				return;
+
+			stage.history[size_t(stage.writePos)] = float(x);
+			stage.writePos = (stage.writePos + 1) % fftSize;
+
+			if (++stage.sinceLastFrame == hopSize)
+			{
+				stage.sinceLastFrame = 0;
+				performFFT(stage);
+			}
+		}
+	}
+
+	void performFFT(Stage& stage)
+	{
+		auto* data = mFFTData.getWritePointer(0);
+		const auto tail = fftSize - stage.writePos;
+		std::copy(stage.history.begin() + stage.writePos, stage.history.end(), data);
+		std::copy(stage.history.begin(), stage.history.begin() + stage.writePos, data + tail);
+
+		mWindowing->multiplyWithWindowingTable(data, size_t(fftSize));
+		mFFT->performFrequencyOnlyForwardTransform(data);
+
+		juce::FloatVectorOperations::copyWithMultiply(stage.magnitudes.data(), data, 2.0f / fftSize, int(stage.magnitudes.size()));
+	}
+
+	void stitch()
+	{
+		for (size_t bin = 0; bin < mBinMap.size(); ++bin)
+		{
+			const auto& map = mBinMap[bin];
+			const auto* mags = mStages[size_t(map.stage)].magnitudes.data();
+
+			if (map.high - map.low > 1)
+			{
+				// bin is wider than the FFT resolution, keep the peak so tones don't vanish
+				mSpectrum[bin] = juce::FloatVectorOperations::findMaximum(mags + map.low, map.high - map.low + 1);
+			}
+			else
+			{
+				const auto i = juce::jmin(int(map.centre), fftSize / 2 - 1);
+				const auto frac = map.centre - float(i);
+				mSpectrum[bin] = mags[i] + frac * (mags[i + 1] - mags[i]);
+			}
+		}
+	}
+
+	//==============================================================================
+	std::unique_ptr<juce::dsp::FFT> mFFT;
+	juce::AudioBuffer<float> mFFTData;
+	std::unique_ptr<juce::dsp::WindowingFunction<float>> mWindowing;
+
+	std::array<Stage, numStages> mStages;
+	std::array<BinMap, numLogBins> mBinMap;
+	std::vector<float> mSpectrum;
+
+	Type mSampleRate = 48000;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultiResolutionSpectrum)
+};
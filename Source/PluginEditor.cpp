@@ -9,9 +9,13 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "Analyser.h"
+#include "TraceEvents.h"
 
 static int clickRadius = 4;
 static float maxDB = 24.0f;
+static float maxGroupDelayMs = 10.0f;
+static const std::array<int, 5> crossfadeTimesMs{ 0, 2, 5, 10, 20 };
+static const juce::Colour backgroundColour{ static_cast<juce::uint8>(20), static_cast<juce::uint8>(20), static_cast<juce::uint8>(20) };
 
 //==============================================================================
 Gainrev2AudioProcessorEditor::Gainrev2AudioProcessorEditor (Gainrev2AudioProcessor& p)
@@ -49,6 +53,7 @@ Gainrev2AudioProcessorEditor::Gainrev2AudioProcessorEditor (Gainrev2AudioProcess
     addAndMakeVisible(mBrandingFrame);
     addAndMakeVisible(mFrame);
     addAndMakeVisible(mGainSlider);
+    addAndMakeVisible(mLoadMeter);
 
     mAttachments.add(new juce::AudioProcessorValueTreeState::SliderAttachment(audioProcessor.getPluginState(), Gainrev2AudioProcessor::paramOutput, mGainSlider));
     mGainSlider.setTooltip("Gain");
@@ -58,28 +63,39 @@ Gainrev2AudioProcessorEditor::Gainrev2AudioProcessorEditor (Gainrev2AudioProcess
     setSize(size.x, size.y);
     setResizeLimits(1000, 680, 2560, 1440);
     
+    // everything gets built below, so start from the current generations
+    audioProcessor.getChangesSince(mSeenGenerations);
     updateFreqRespone();
 
 #ifdef JUCE_OPENGL
-    openGLContext.attachTo(*getTopLevelComponent());
+    // attached to the editor itself so renderOpenGL works in editor coordinates,
+    // whichever wrapper window the host puts us in
+    // multisampled, so the curve renderer's triangle strips get smooth edges
+    juce::OpenGLPixelFormat pixelFormat;
+    pixelFormat.multisamplingLevel = 4;
+    openGLContext.setPixelFormat(pixelFormat);
+    openGLContext.setMultisamplingEnabled(true);
+    openGLContext.setRenderer(this);
+    openGLContext.attachTo(*this);
 #endif // JUCE_OPENGL
 
-    audioProcessor.addChangeListener(this);
+    audioProcessor.setAnalysersActive(true);
 
-    juce::Timer::startTimerHz(120);
+    mFramePacer.start();
     
 }
 
 Gainrev2AudioProcessorEditor::~Gainrev2AudioProcessorEditor()
 {
     juce::PopupMenu::dismissAllActiveMenus();
+    mFramePacer.stop();
 
-    audioProcessor.removeChangeListener(this);
-    
 #ifdef JUCE_OPENGL
     openGLContext.detach();
 #endif // JUCE_OPENGL
 
+    audioProcessor.setAnalysersActive(false);
+
     
 }
 
@@ -103,14 +119,135 @@ Gainrev2AudioProcessorEditor::~Gainrev2AudioProcessorEditor()
 
 void Gainrev2AudioProcessorEditor::paint(juce::Graphics& g)
 {
+    EQ_TRACE_SCOPE("Editor paint");
     const auto inputColour = juce::Colours::greenyellow;
     const auto outputColour = juce::Colours::indianred;
 
     juce::Graphics::ScopedSaveState state(g);
+    const auto paintStart = juce::Time::getMillisecondCounterHiRes();
+
+#ifdef JUCE_OPENGL
+    mUseGLCurves = openGLContext.isAttached() && mCurves.isReady();
+    mNumGLCurves = 0;
+#endif // JUCE_OPENGL
+
+    // frame, grid and labels only change with the size, the display scale or
+    // the plot's transparent hole for GL content, so they are drawn once into an image
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const auto hasHole = isSpectrogramVisible() || mUseGLCurves;
+    if (!mBackground.isValid() || scale != mBackgroundScale || hasHole != mBackgroundHasHole)
+        renderBackground(scale, hasHole);
+
+    g.drawImageTransformed(mBackground, juce::AffineTransform::scale(1.0f / mBackgroundScale));
+
+    g.reduceClipRegion(mPlotFrame);
+
+    g.setFont(16.0f);
+
+    const juce::Colour traceColours[] = { juce::Colours::skyblue, juce::Colours::plum };
+
+    for (int input = 1; input >= 0 && !isSpectrogramVisible(); --input)
+    {
+        const auto numTraces = audioProcessor.getAnalyserNumTraces(input == 1);
+        for (int trace = 0; trace < numTraces; ++trace)
+        {
+            const auto colour = numTraces > 1 ? traceColours[trace] : juce::Colours::grey;
+            // the analysis thread prebuilds the paths, only build here until its first one for these bounds arrives
+            auto& path = mAnalyserPaths[size_t(input)][size_t(trace)];
+            auto& points = mAnalyserPoints[size_t(input)][size_t(trace)];
+            if (!audioProcessor.swapAnalyserPlot(path, points, input == 1, trace) && !mAnalyserPathsValid)
+            {
+                audioProcessor.createAnalyserPlot(path, mPlotFrame, 20.0f, input == 1, trace);
+                Polyline::fromPath(path, points);
+            }
+
+            drawCurve(g, path, points, colour, input == 1 ? 0.2f : 1.0f, colour.withAlpha(0.2f));
+        }
+    }
+
+    mAnalyserPathsValid = true;
+
+    if (audioProcessor.getAnalyserChannelMode() != AnalyserChannelMode::Sum)
+        drawStereoReadout(g);
+
+    if (juce::Time::getMillisecondCounter() < mDropWarningUntil)
+    {
+        g.setColour(juce::Colours::orange);
+        g.setFont(12.0f);
+        g.drawFittedText("Analyser falling behind", mPlotFrame.reduced(6, 4), juce::Justification::bottomRight, 1);
+        g.setFont(16.0f);
+    }
+
+    for (size_t i = 0; i < audioProcessor.getNumBands(); ++i)
+    {
+        auto* bandEditor = mBandEditor.getUnchecked(int(i));
+        auto* band = audioProcessor.getBand(i);
+
+        drawCurve(g, bandEditor->bFrequencyResponse, bandEditor->bFrequencyPoints, band->active ? band->colour : band->colour.withAlpha(0.3f), 1.0f);
+        g.setColour(mDraggingBand == (int)i ? band->colour : band->colour.withAlpha(0.6f));
+
+        auto x = juce::roundToInt(mPlotFrame.getX() + mPlotFrame.getWidth() * getPosForFreq((float)band->frequency));
+        auto y = juce::roundToInt(getPosForGain((float)band->gain, (float)mPlotFrame.getY(), (float)mPlotFrame.getBottom()));
+
+        g.drawVerticalLine(x, (float)mPlotFrame.getY(), (float)y - 5);
+        g.drawVerticalLine(x, (float)y + 5, (float)mPlotFrame.getBottom());
+        g.fillEllipse((float)x - 3, (float)y - 3, 6.0f, 6.0f);
+    }
+
+    if (mDraggingBand >= 0)
+    {
+        const auto overlayColour = audioProcessor.getBandColour(size_t(mDraggingBand)).withAlpha(0.5f);
+        if (!mBandPhasePath.isEmpty())
+            drawCurve(g, mBandPhasePath, mBandPhasePoints, overlayColour, 1.0f);
+        if (!mBandDelayPath.isEmpty())
+            drawCurve(g, mBandDelayPath, mBandDelayPoints, overlayColour, 1.0f);
+    }
+
+    g.setFont(12.0f);
+    if (audioProcessor.getPhaseOverlay())
+    {
+        g.setColour(juce::Colours::lightgreen.withAlpha(0.7f));
+        drawCurve(g, mPhasePath, mPhasePoints, juce::Colours::lightgreen.withAlpha(0.7f), 1.0f);
+        g.drawFittedText("phase +/-180 deg", mPlotFrame.reduced(6, 4), juce::Justification::topRight, 1);
+    }
+    if (audioProcessor.getGroupDelayOverlay())
+    {
+        g.setColour(juce::Colours::cyan.withAlpha(0.7f));
+        drawCurve(g, mGroupDelayPath, mGroupDelayPoints, juce::Colours::cyan.withAlpha(0.7f), 1.0f);
+        g.drawFittedText("group delay +/-" + juce::String(maxGroupDelayMs, 0) + " ms", mPlotFrame.reduced(6, 18), juce::Justification::topRight, 1);
+    }
+
+    drawCurve(g, mFrequencyResponse, mFrequencyPoints, juce::Colours::silver, 1.0f);
+
+#ifdef JUCE_OPENGL
+    if (mUseGLCurves)
+    {
+        mCurves.setCurves(mGLCurves, mNumGLCurves);
+    }
+#endif // JUCE_OPENGL
+
+    mFramePacer.reportPaintTime(juce::Time::getMillisecondCounterHiRes() - paintStart);
+}
+
+void Gainrev2AudioProcessorEditor::renderBackground(float scale, bool withHole)
+{
+    mBackgroundScale = scale;
+    mBackgroundHasHole = withHole;
+    mBackground = juce::Image(juce::Image::ARGB, juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+        juce::jmax(1, juce::roundToInt(getHeight() * scale)), true);
+
+    juce::Graphics g(mBackground);
+    g.addTransform(juce::AffineTransform::scale(scale));
 
     //auto background = juce::Colour(static_cast 53, 47, 47);
     //g.setColour(background);
-    g.fillAll({static_cast<juce::uint8>(20),static_cast<juce::uint8>(20), static_cast<juce::uint8>(20)});
+    {
+        // leave the plot transparent so the GL spectrogram underneath shows through
+        juce::Graphics::ScopedSaveState fillState(g);
+        if (withHole)
+            g.excludeClipRegion(mPlotFrame.reduced(2));
+        g.fillAll(backgroundColour);
+    }
     //g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
 
     g.setFont(12.0f);
@@ -141,48 +278,12 @@ void Gainrev2AudioProcessorEditor::paint(juce::Graphics& g)
         50, 14, juce::Justification::left, 1);
     g.drawFittedText(juce::String(-maxDB / 2) + " dB", mPlotFrame.getX() + 3, juce::roundToInt(mPlotFrame.getY() + 2 + 0.75 * mPlotFrame.getHeight()),
         50, 14, juce::Justification::left, 1);
-
-    g.reduceClipRegion(mPlotFrame);
-
-    g.setFont(16.0f);
-
-    audioProcessor.createAnalyserPlot(mAnalyserPath, mPlotFrame, 20.0f, true);
-    g.setColour(juce::Colours::grey);
-    g.strokePath(mAnalyserPath, juce::PathStrokeType(0.2f));
-    g.setColour(juce::Colours::grey.withAlpha(0.2f));
-    g.fillPath(mAnalyserPath);
-
-
-    audioProcessor.createAnalyserPlot(mAnalyserPath, mPlotFrame, 20.0f, false);
-    g.setColour(juce::Colours::grey);
-    g.strokePath(mAnalyserPath, juce::PathStrokeType(1.0f));
-    g.setColour(juce::Colours::grey.withAlpha(0.2f));
-    g.fillPath(mAnalyserPath);
-
-    for (size_t i = 0; i < audioProcessor.getNumBands(); ++i)
-    {
-        auto* bandEditor = mBandEditor.getUnchecked(int(i));
-        auto* band = audioProcessor.getBand(i);
-
-        g.setColour(band->active ? band->colour : band->colour.withAlpha(0.3f));
-        g.strokePath(bandEditor->bFrequencyResponse, juce::PathStrokeType(1.0f));
-        g.setColour(mDraggingBand == (int)i ? band->colour : band->colour.withAlpha(0.6f));
-
-        auto x = juce::roundToInt(mPlotFrame.getX() + mPlotFrame.getWidth() * getPosForFreq((float)band->frequency));
-        auto y = juce::roundToInt(getPosForGain((float)band->gain, (float)mPlotFrame.getY(), (float)mPlotFrame.getBottom()));
-
-        g.drawVerticalLine(x, (float)mPlotFrame.getY(), (float)y - 5);
-        g.drawVerticalLine(x, (float)y + 5, (float)mPlotFrame.getBottom());
-        g.fillEllipse((float)x - 3, (float)y - 3, 6.0f, 6.0f);
-    }
-
-    g.setColour(juce::Colours::silver);
-    g.strokePath(mFrequencyResponse, juce::PathStrokeType(1.0f));
 }
 
 void Gainrev2AudioProcessorEditor::resized()
 {
     audioProcessor.setSavedSize({ getWidth(), getHeight() });
+    mBackground = juce::Image();
     mPlotFrame = getLocalBounds();
 
     auto bandSpace = mPlotFrame.removeFromBottom(getHeight() / 3);
@@ -192,7 +293,9 @@ void Gainrev2AudioProcessorEditor::resized()
     {
         bandEditor->setBounds(bandSpace.removeFromLeft(width));
     }
-    mName.setBounds(bandSpace.removeFromBottom(bandSpace.getHeight() / 2));
+    auto nameSpace = bandSpace.removeFromBottom(bandSpace.getHeight() / 2);
+    mLoadMeter.setBounds(nameSpace.removeFromBottom(18).reduced(8, 2));
+    mName.setBounds(nameSpace);
     //mBrandingFrame.setBounds(bandSpace.removeFromBottom(bandSpace.getHeight() / 2));
     mFrame.setBounds(bandSpace.removeFromTop(bandSpace.getHeight()));
     //mGainSlider.setBounds(getWidth() - 80, getHeight() - 80, 80, 80);
@@ -200,8 +303,20 @@ void Gainrev2AudioProcessorEditor::resized()
     mGainSlider.setBounds(mFrame.getBounds().reduced(8));
 
     mPlotFrame.reduce(3, 3);
+
+#ifdef JUCE_OPENGL
+    {
+        const juce::SpinLock::ScopedLockType boundsLock(mGLBoundsLock);
+        mGLPlotFrame = mPlotFrame.reduced(2);
+        mGLWidth = getWidth();
+        mGLHeight = getHeight();
+    }
+#endif // JUCE_OPENGL
     //mBrandingFrame = bandSpace.reduced(5);
 
+    audioProcessor.setResponseResolution(mPlotFrame.getWidth());
+    audioProcessor.setAnalyserPlotBounds(mPlotFrame, 20.0f);
+    mAnalyserPathsValid = false;
     updateFreqRespone();
     
     // This is generally where you'll want to lay out the positions of any
@@ -213,17 +328,88 @@ void Gainrev2AudioProcessorEditor::resized()
     
 }
 
-void Gainrev2AudioProcessorEditor::timerCallback()
+void Gainrev2AudioProcessorEditor::updateFrame()
 {
-    if (audioProcessor.checkForNewAnalyserData())
+    // the warning stays up for a second after the last dropped block
+    const auto dropped = audioProcessor.getAnalyserDroppedBlocks();
+    const auto now = juce::Time::getMillisecondCounter();
+    const auto showWarning = now < mDropWarningUntil;
+
+    if (dropped != mLastDroppedBlocks)
+    {
+        mLastDroppedBlocks = dropped;
+        mDropWarningUntil = now + 1000;
+    }
+
+    // however many parameters moved since the last frame, the curves are
+    // rebuilt once per frame and only for the bands that actually changed
+    applyChanges(audioProcessor.getChangesSince(mSeenGenerations));
+
+    if (audioProcessor.checkForNewAnalyserData() || showWarning != (now < mDropWarningUntil))
         repaint(mPlotFrame);
+
+    if (now >= mNextLoadUpdate)
+    {
+        mNextLoadUpdate = now + 250;
+        mLoadMeter.update();
+    }
 }
 
-void Gainrev2AudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster* sender)
+void Gainrev2AudioProcessorEditor::applyChanges(juce::uint32 changes)
 {
-    juce::ignoreUnused(sender);
-    updateFreqRespone();
-    repaint();
+    if (changes == 0)
+        return;
+
+    if ((changes & Gainrev2AudioProcessor::globalChanged) != 0)
+    {
+        updateFreqRespone(changes);
+        repaint();
+        return;
+    }
+
+    // only the changed bands' markers, where they were and where they are, and
+    // the stretches of their own curves and of the composite that actually
+    // moved; kept as separate rectangles so a band at each end of the plot
+    // doesn't repaint everything in between
+    const auto overlays = (changes & Gainrev2AudioProcessor::overlaysChanged) != 0;
+    const auto isChanged = [changes](int band) { return (changes & (juce::uint32(1) << band)) != 0; };
+
+    juce::RectangleList<int> areas;
+    for (int i = 0; i < mBandEditor.size(); ++i)
+    {
+        if (isChanged(i))
+        {
+            areas.add(getBandMarkerArea(i));
+            auto* bandEditor = mBandEditor.getUnchecked(i);
+            std::swap(bandEditor->bPreviousFrequencyPoints, bandEditor->bFrequencyPoints);
+        }
+    }
+    if (overlays)
+        areas.add(getOverlayArea());
+    std::swap(mPreviousFrequencyPoints, mFrequencyPoints);
+
+    updateFreqRespone(changes);
+
+    for (int i = 0; i < mBandEditor.size(); ++i)
+    {
+        if (isChanged(i))
+        {
+            const auto* bandEditor = mBandEditor.getUnchecked(i);
+            areas.add(getBandMarkerArea(i));
+
+            // a curve that didn't move may still have changed colour, e.g. when the band was switched off
+            auto curveArea = getCurveChangeArea(bandEditor->bPreviousFrequencyPoints, bandEditor->bFrequencyPoints);
+            if (curveArea.isEmpty())
+                curveArea = bandEditor->bFrequencyResponse.getBounds().expanded(2.0f).getSmallestIntegerContainer().getIntersection(mPlotFrame);
+            areas.add(curveArea);
+        }
+    }
+    if (overlays)
+        areas.add(getOverlayArea());
+    areas.add(getCurveChangeArea(mPreviousFrequencyPoints, mFrequencyPoints));
+
+    for (const auto& area : areas)
+        repaint(area);
 }
 
 void Gainrev2AudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
@@ -254,6 +440,73 @@ void Gainrev2AudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
             }
         }
     }
+
+    const auto channelMode = audioProcessor.getAnalyserChannelMode();
+
+    mContextMenu.clear();
+    mContextMenu.addItem(1, "Multi-resolution analyser", true, audioProcessor.getAnalyserMultiResolution());
+    mContextMenu.addItem(6, "Show phase", true, audioProcessor.getPhaseOverlay());
+    mContextMenu.addItem(7, "Show group delay", true, audioProcessor.getGroupDelayOverlay());
+    mContextMenu.addSeparator();
+    mContextMenu.addItem(2, "Analyse summed", true, channelMode == AnalyserChannelMode::Sum);
+    mContextMenu.addItem(3, "Analyse left / right", true, channelMode == AnalyserChannelMode::LeftRight);
+    mContextMenu.addItem(4, "Analyse mid / side", true, channelMode == AnalyserChannelMode::MidSide);
+#ifdef JUCE_OPENGL
+    mContextMenu.addSeparator();
+    mContextMenu.addItem(5, "Spectrogram", true, audioProcessor.getSpectrogramEnabled());
+#endif // JUCE_OPENGL
+
+    const auto decimation = audioProcessor.getAnalyserDecimation();
+    const auto maxDecimation = audioProcessor.getMaxAnalyserDecimation();
+    juce::PopupMenu decimationMenu;
+    decimationMenu.addItem(10, "Auto", true, decimation == 0);
+    decimationMenu.addItem(11, "None", true, decimation == 1);
+    decimationMenu.addItem(12, "2x", maxDecimation >= 2, decimation == 2);
+    decimationMenu.addItem(13, "4x", maxDecimation >= 4, decimation == 4);
+    mContextMenu.addSubMenu("Analyser pre-decimation", decimationMenu);
+
+    const auto crossfadeMs = juce::roundToInt(audioProcessor.getCrossfadeTime() * 1000.0);
+    juce::PopupMenu crossfadeMenu;
+    for (int i = 0; i < int(crossfadeTimesMs.size()); ++i)
+        crossfadeMenu.addItem(30 + i, crossfadeTimesMs[size_t(i)] == 0 ? juce::String("Off") : juce::String(crossfadeTimesMs[size_t(i)]) + " ms",
+            true, crossfadeMs == crossfadeTimesMs[size_t(i)]);
+    mContextMenu.addSubMenu("Switching crossfade", crossfadeMenu);
+    mContextMenu.addItem(8, "Solo plays band-pass", true, audioProcessor.getSoloListen());
+    mContextMenu.addSeparator();
+    mContextMenu.addItem(20, "Copy DSP load report");
+    if (TraceEvents::enabled)
+        mContextMenu.addItem(21, "Save timeline trace...");
+
+    mContextMenu.showMenuAsync(juce::PopupMenu::Options().
+        withTargetComponent(this).withTargetScreenArea({ event.getScreenX(), event.getScreenY(), 1, 1 }),
+        [this](int selected)
+        {
+            if (selected == 1)
+                audioProcessor.setAnalyserMultiResolution(!audioProcessor.getAnalyserMultiResolution());
+            else if (selected >= 2 && selected <= 4)
+                audioProcessor.setAnalyserChannelMode(static_cast<AnalyserChannelMode>(selected - 2));
+            else if (selected == 5)
+                audioProcessor.setSpectrogramEnabled(!audioProcessor.getSpectrogramEnabled());
+            else if (selected == 6)
+                audioProcessor.setPhaseOverlay(!audioProcessor.getPhaseOverlay());
+            else if (selected == 7)
+                audioProcessor.setGroupDelayOverlay(!audioProcessor.getGroupDelayOverlay());
+            else if (selected == 8)
+                audioProcessor.setSoloListen(!audioProcessor.getSoloListen());
+            else if (selected >= 10 && selected <= 13)
+                audioProcessor.setAnalyserDecimation(selected == 10 ? 0 : 1 << (selected - 11));
+            else if (selected >= 30 && selected < 30 + int(crossfadeTimesMs.size()))
+                audioProcessor.setCrossfadeTime(crossfadeTimesMs[size_t(selected - 30)] / 1000.0);
+            else if (selected == 20)
+            {
+                const auto report = audioProcessor.getLoadMeter().getReport();
+                DBG(report);
+                juce::SystemClipboard::copyTextToClipboard(report);
+            }
+            else if (selected == 21)
+                saveTrace();
+            repaint();
+        });
 }
 
 void Gainrev2AudioProcessorEditor::mouseMove(const juce::MouseEvent& event)
@@ -280,8 +533,9 @@ void Gainrev2AudioProcessorEditor::mouseMove(const juce::MouseEvent& event)
 
                     if (i != mDraggingBand)
                     {
+                        const auto previous = mDraggingBand;
                         mDraggingBand = i;
-                        repaint(mPlotFrame);
+                        onHoverChanged(previous);
                     }
                     return;
                 }
@@ -289,10 +543,28 @@ void Gainrev2AudioProcessorEditor::mouseMove(const juce::MouseEvent& event)
         }
     }
 
-    mDraggingBand = -1;
     mDraggingGain = false;
     setMouseCursor(juce::MouseCursor(juce::MouseCursor::NormalCursor));
-    repaint(mPlotFrame);
+
+    if (mDraggingBand >= 0)
+    {
+        const auto previous = mDraggingBand;
+        mDraggingBand = -1;
+        onHoverChanged(previous);
+    }
+}
+
+void Gainrev2AudioProcessorEditor::onHoverChanged(int previousBand)
+{
+    // only the two markers change, unless the hovered band's overlay curve has to follow
+    auto area = getBandMarkerArea(previousBand).getUnion(getBandMarkerArea(mDraggingBand));
+    if (audioProcessor.getPhaseOverlay() || audioProcessor.getGroupDelayOverlay())
+    {
+        area = area.getUnion(getBandOverlayArea());
+        updateOverlayPaths();
+        area = area.getUnion(getBandOverlayArea());
+    }
+    repaint(area);
 }
 
 void Gainrev2AudioProcessorEditor::mouseDrag(const juce::MouseEvent& event)
@@ -342,24 +614,279 @@ void Gainrev2AudioProcessorEditor::mouseDoubleClick(const juce::MouseEvent& even
     }
 } 
 
-void Gainrev2AudioProcessorEditor::updateFreqRespone()
+void Gainrev2AudioProcessorEditor::updateFreqRespone(juce::uint32 changes)
 {
-    auto pixelsPerDouble = 2.0f * mPlotFrame.getHeight() / juce::Decibels::decibelsToGain(maxDB);
+    audioProcessor.updateResponses();
+
+    auto pixelsPerDB = 0.5f * mPlotFrame.getHeight() / maxDB;
+    mMarkerX.resize(size_t(mBandEditor.size()));
+    const auto global = (changes & Gainrev2AudioProcessor::globalChanged) != 0;
 
     for (int i = 0; i < mBandEditor.size(); ++i)
     {
+        if (!global && (changes & (juce::uint32(1) << i)) == 0)
+            continue;
+
         auto* bandEditor = mBandEditor.getUnchecked(i);
 
         if (auto* band = audioProcessor.getBand((size_t)i))
         {
             bandEditor->updateControls(band->type);
+            mMarkerX[size_t(i)] = juce::roundToInt(mPlotFrame.getX() + mPlotFrame.getWidth() * getPosForFreq(band->frequency));
             bandEditor->bFrequencyResponse.clear();
-            audioProcessor.createFrequencyPlot(bandEditor->bFrequencyResponse, band->magnitudes, mPlotFrame.withX(mPlotFrame.getX() + 1), pixelsPerDouble);
+            audioProcessor.createFrequencyPlot(bandEditor->bFrequencyResponse, band->responseDB, mPlotFrame.withX(mPlotFrame.getX() + 1), pixelsPerDB);
+            Polyline::fromPath(bandEditor->bFrequencyResponse, bandEditor->bFrequencyPoints);
         }
         bandEditor->updateSoloState(audioProcessor.getBandSolo(i));
     }
     mFrequencyResponse.clear();
-    audioProcessor.createFrequencyPlot(mFrequencyResponse, audioProcessor.getMagnitudes(), mPlotFrame, pixelsPerDouble);
+    audioProcessor.createFrequencyPlot(mFrequencyResponse, audioProcessor.getCompositeResponse(), mPlotFrame, pixelsPerDB);
+    Polyline::fromPath(mFrequencyResponse, mFrequencyPoints);
+
+    // overlays keep the last finished curves until the background worker delivers new ones
+    if (audioProcessor.getOverlayCurves(mOverlayCurves) || global)
+        updateOverlayPaths();
+}
+
+void Gainrev2AudioProcessorEditor::updateOverlayPaths()
+{
+    mPhasePath.clear();
+    mGroupDelayPath.clear();
+    mBandPhasePath.clear();
+    mBandDelayPath.clear();
+    mPhasePoints.clear();
+    mGroupDelayPoints.clear();
+    mBandPhasePoints.clear();
+    mBandDelayPoints.clear();
+
+    const auto numPoints = audioProcessor.getCompositeResponse().size();
+    if (mOverlayCurves.phase.size() != numPoints)
+        return;
+
+    const auto pixelsPerDegree = 0.5f * mPlotFrame.getHeight() / 180.0f;
+    const auto pixelsPerMs = 0.5f * mPlotFrame.getHeight() / maxGroupDelayMs;
+    const auto hasDraggedBand = juce::isPositiveAndBelow(mDraggingBand, int(mOverlayCurves.bandPhase.size()));
+
+    if (audioProcessor.getPhaseOverlay())
+    {
+        audioProcessor.createFrequencyPlot(mPhasePath, mOverlayCurves.phase, mPlotFrame, pixelsPerDegree);
+        if (hasDraggedBand)
+            audioProcessor.createFrequencyPlot(mBandPhasePath, mOverlayCurves.bandPhase[size_t(mDraggingBand)], mPlotFrame, pixelsPerDegree);
+    }
+    if (audioProcessor.getGroupDelayOverlay())
+    {
+        audioProcessor.createFrequencyPlot(mGroupDelayPath, mOverlayCurves.delay, mPlotFrame, pixelsPerMs);
+        if (hasDraggedBand)
+            audioProcessor.createFrequencyPlot(mBandDelayPath, mOverlayCurves.bandDelay[size_t(mDraggingBand)], mPlotFrame, pixelsPerMs);
+    }
+
+    Polyline::appendPath(mPhasePath, mPhasePoints);
+    Polyline::appendPath(mGroupDelayPath, mGroupDelayPoints);
+    Polyline::appendPath(mBandPhasePath, mBandPhasePoints);
+    Polyline::appendPath(mBandDelayPath, mBandDelayPoints);
+}
+
+juce::Rectangle<int> Gainrev2AudioProcessorEditor::getBandOverlayArea() const
+{
+    const auto bounds = mBandPhasePath.getBounds().getUnion(mBandDelayPath.getBounds());
+    return bounds.isEmpty() ? juce::Rectangle<int>() : bounds.expanded(2.0f).getSmallestIntegerContainer();
+}
+
+juce::Rectangle<int> Gainrev2AudioProcessorEditor::getOverlayArea() const
+{
+    const auto boundsOf = [](const juce::Path& path)
+    {
+        return path.getBounds().expanded(2.0f).getSmallestIntegerContainer();
+    };
+
+    // the overlays are only rebuilt when the background worker delivers new curves
+    if (!audioProcessor.getPhaseOverlay() && !audioProcessor.getGroupDelayOverlay())
+        return {};
+
+    return boundsOf(mPhasePath).getUnion(boundsOf(mGroupDelayPath)).getUnion(getBandOverlayArea()).getIntersection(mPlotFrame);
+}
+
+juce::Rectangle<int> Gainrev2AudioProcessorEditor::getCurveChangeArea(const Polyline::Points& before, const Polyline::Points& after) const
+{
+    if (before.size() != after.size())
+        return mPlotFrame;
+
+    // a band only moves the composite where its own curve changed, usually a
+    // few octaves around its frequency, so compare point by point and cover
+    // the segments on either side of every point that moved
+    auto left = std::numeric_limits<float>::max(), right = std::numeric_limits<float>::lowest();
+    auto top = left, bottom = right;
+    const auto numPoints = after.size();
+    for (size_t i = 0; i < numPoints; ++i)
+    {
+        if (before[i].getDistanceSquaredFrom(after[i]) < 1.0e-4f)
+            continue;
+
+        for (auto j = i > 0 ? i - 1 : 0; j <= juce::jmin(i + 1, numPoints - 1); ++j)
+        {
+            for (const auto& point : { before[j], after[j] })
+            {
+                left = juce::jmin(left, point.x);
+                right = juce::jmax(right, point.x);
+                top = juce::jmin(top, point.y);
+                bottom = juce::jmax(bottom, point.y);
+            }
+        }
+    }
+
+    if (left > right)
+        return {};
+
+    const auto area = juce::Rectangle<float>::leftTopRightBottom(left, top, right, bottom);
+    return area.expanded(2.0f).getSmallestIntegerContainer().getIntersection(mPlotFrame);
+}
+
+juce::Rectangle<int> Gainrev2AudioProcessorEditor::getBandMarkerArea(int band) const
+{
+    // the position from the last update, so the old marker still gets erased after the band moved
+    if (!juce::isPositiveAndBelow(band, int(mMarkerX.size())))
+        return {};
+
+    const auto x = mMarkerX[size_t(band)];
+    return { x - clickRadius - 1, mPlotFrame.getY(), 2 * clickRadius + 2, mPlotFrame.getHeight() };
+}
+
+bool Gainrev2AudioProcessorEditor::isSpectrogramVisible() const
+{
+#ifdef JUCE_OPENGL
+    return audioProcessor.getSpectrogramEnabled() && openGLContext.isAttached();
+#else
+    return false;
+#endif // JUCE_OPENGL
+}
+
+void Gainrev2AudioProcessorEditor::drawCurve(juce::Graphics& g, const juce::Path& path, const Polyline::Points& points,
+    juce::Colour strokeColour, float strokeWidth, juce::Colour fillColour)
+{
+#ifdef JUCE_OPENGL
+    if (mUseGLCurves)
+    {
+        // the slots stay at their high-water count, so they keep their point storage from frame to frame
+        if (mNumGLCurves == mGLCurves.size())
+            mGLCurves.emplace_back();
+
+        auto& curve = mGLCurves[mNumGLCurves++];
+        curve.points = points;
+        curve.strokeColour = strokeColour;
+        curve.strokeWidth = strokeWidth;
+        curve.fillColour = fillColour;
+        curve.fillBaseline = float(mPlotFrame.getBottom());
+        return;
+    }
+#endif // JUCE_OPENGL
+
+    if (!fillColour.isTransparent())
+    {
+        g.setColour(fillColour);
+        g.fillPath(path);
+    }
+    g.setColour(strokeColour);
+    g.strokePath(path, juce::PathStrokeType(strokeWidth));
+}
+
+#ifdef JUCE_OPENGL
+void Gainrev2AudioProcessorEditor::newOpenGLContextCreated()
+{
+    mSpectrogramRows.resize(size_t(SpectrogramRenderer::numHistoryRows) * Gainrev2AudioProcessor::spectrogramWidth);
+    mSpectrogram.create(openGLContext);
+    mCurves.create(openGLContext);
+}
+
+void Gainrev2AudioProcessorEditor::renderOpenGL()
+{
+    EQ_TRACE_SCOPE("GL render");
+    juce::OpenGLHelpers::clear(backgroundColour);
+
+    juce::Rectangle<int> plotFrame;
+    int width, height;
+    {
+        const juce::SpinLock::ScopedLockType boundsLock(mGLBoundsLock);
+        plotFrame = mGLPlotFrame;
+        width = mGLWidth;
+        height = mGLHeight;
+    }
+
+    // GL's origin is bottom left and counts physical pixels
+    const auto scale = static_cast<float>(openGLContext.getRenderingScale());
+    auto viewport = (plotFrame.toFloat() * scale).toNearestInt();
+    viewport.setY(juce::roundToInt(height * scale) - viewport.getBottom());
+
+    if (audioProcessor.getSpectrogramEnabled())
+    {
+        const auto numRows = audioProcessor.readSpectrogramRows(mSpectrogramRows.data(), SpectrogramRenderer::numHistoryRows);
+        mSpectrogram.uploadRows(mSpectrogramRows.data(), numRows);
+        mSpectrogram.render(openGLContext, viewport);
+    }
+
+    mCurves.render(openGLContext, { width, height }, scale, viewport);
+}
+
+void Gainrev2AudioProcessorEditor::openGLContextClosing()
+{
+    mSpectrogram.release(openGLContext);
+    mCurves.release(openGLContext);
+
+    // the render thread ends with the context, reopened editors start a new one
+    TraceEvents::releaseThread();
+}
+#endif // JUCE_OPENGL
+
+void Gainrev2AudioProcessorEditor::drawStereoReadout(juce::Graphics& g)
+{
+    const auto readout = audioProcessor.getStereoReadout();
+    if (!readout.valid)
+        return;
+
+    // one width bar per octave, lined up with the vertical grid
+    if (readout.hasBands)
+    {
+        const auto bandWidth = mPlotFrame.getWidth() / float(StereoReadout::numBands);
+        g.setColour(juce::Colours::plum.withAlpha(0.6f));
+        for (int band = 0; band < StereoReadout::numBands; ++band)
+        {
+            g.fillRect(juce::Rectangle<float>(mPlotFrame.getX() + band * bandWidth + 2.0f, mPlotFrame.getY() + 4.0f,
+                (bandWidth - 4.0f) * readout.width[size_t(band)], 3.0f));
+        }
+    }
+
+    auto meter = juce::Rectangle<float>(float(mPlotFrame.getRight() - 130), float(mPlotFrame.getY() + 12), 120.0f, 6.0f);
+    g.setColour(juce::Colours::silver.withAlpha(0.3f));
+    g.fillRect(meter);
+
+    const auto centre = meter.getCentreX();
+    const auto pos = centre + readout.correlation * meter.getWidth() * 0.5f;
+    g.setColour(readout.correlation < 0.0f ? juce::Colours::indianred : juce::Colours::greenyellow);
+    g.fillRect(juce::Rectangle<float>(juce::jmin(centre, pos), meter.getY(), std::abs(pos - centre), meter.getHeight()));
+
+    g.setColour(juce::Colours::silver);
+    g.setFont(12.0f);
+    g.drawFittedText("Correlation " + juce::String(readout.correlation, 2), meter.translated(0.0f, 8.0f).withHeight(14.0f).toNearestInt(),
+        juce::Justification::centred, 1);
+}
+
+void Gainrev2AudioProcessorEditor::saveTrace()
+{
+    const auto defaultFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("EQucer trace.json");
+    mTraceChooser = std::make_unique<juce::FileChooser>("Save timeline trace", defaultFile, "*.json");
+
+    // the rings keep recording meanwhile, the trace ends when the file is picked
+    mTraceChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+        | juce::FileBrowserComponent::warnAboutOverwriting,
+        [](const juce::FileChooser& chooser)
+        {
+            const auto file = chooser.getResult();
+            if (file == juce::File())
+                return;
+
+            const auto result = TraceEvents::writeChromeTrace(file);
+            if (result.failed())
+                juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Save timeline trace", result.getErrorMessage());
+        });
 }
 
 float Gainrev2AudioProcessorEditor::getPosForFreq(float freq)
@@ -11,14 +11,19 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "BandEditor.h"
+#include "SpectrogramRenderer.h"
+#include "FramePacer.h"
+#include "CurveRenderer.h"
+#include "LoadMeterDisplay.h"
 
 //==============================================================================
 /**
 */
-class Gainrev2AudioProcessorEditor  : public juce::AudioProcessorEditor, 
+class Gainrev2AudioProcessorEditor  : public juce::AudioProcessorEditor
                                       //public juce::Slider::Listener,
-                                      public juce::ChangeListener,
-                                      public juce::Timer
+#ifdef JUCE_OPENGL
+                                    , public juce::OpenGLRenderer
+#endif // JUCE_OPENGL
     
 {
 public:
@@ -31,9 +36,6 @@ public:
 
     //void sliderValueChanged(juce::Slider* slider) override;
 
-    void changeListenerCallback(juce::ChangeBroadcaster* sender) override;
-    void timerCallback() override;
-
     void mouseDown(const juce::MouseEvent& event) override;
 
     void mouseMove(const juce::MouseEvent& event) override;
@@ -42,11 +44,46 @@ public:
     void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
 
     void mouseDoubleClick(const juce::MouseEvent& event) override;
+
+#ifdef JUCE_OPENGL
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override;
+#endif // JUCE_OPENGL
     
 
 private:
 
-    void updateFreqRespone();
+    /** Rebuilds the curves named in changes, see Gainrev2AudioProcessor::getChangesSince(). */
+    void updateFreqRespone(juce::uint32 changes = ~0u);
+    void updateOverlayPaths();
+    void onHoverChanged(int previousBand);
+
+    juce::Rectangle<int> getOverlayArea() const;
+    juce::Rectangle<int> getBandOverlayArea() const;
+    juce::Rectangle<int> getBandMarkerArea(int band) const;
+
+    /** Bounds of only the segments that moved between two versions of a curve on the same grid. */
+    juce::Rectangle<int> getCurveChangeArea(const Polyline::Points& before, const Polyline::Points& after) const;
+
+    void renderBackground(float scale, bool withHole);
+
+    /** Called by the frame pacer once per displayed frame. */
+    void updateFrame();
+    void applyChanges(juce::uint32 changes);
+    void drawStereoReadout(juce::Graphics& g);
+
+    /** Asks for a file and writes the recorded timeline to it, see TraceEvents. */
+    void saveTrace();
+
+    bool isSpectrogramVisible() const;
+
+    /** Strokes and optionally fills a curve, either through the GL curve
+        renderer from its points or, when that isn't available, through the
+        software renderer from its path.
+    */
+    void drawCurve(juce::Graphics& g, const juce::Path& path, const Polyline::Points& points, juce::Colour strokeColour,
+        float strokeWidth, juce::Colour fillColour = juce::Colours::transparentBlack);
 
     static float getFreqPos(float freq);
     static float getPosForFreq(float pos);
@@ -62,25 +99,71 @@ private:
     juce::GroupComponent mBrandingFrame;
     juce::Label mName;
 
+    bool mUseGLCurves = false;
+
+    juce::Image mBackground;
+    float mBackgroundScale = 1.0f;
+    bool mBackgroundHasHole = false;
+
     juce::Path mFrequencyResponse;
-    juce::Path mAnalyserPath;
+    juce::Path mPhasePath;
+    juce::Path mGroupDelayPath;
+    // the dragged band's phase and delay stay separate curves, the GL renderer joins a curve's points
+    juce::Path mBandPhasePath;
+    juce::Path mBandDelayPath;
+    ResponseOverlays::Curves mOverlayCurves;
+    std::array<std::array<juce::Path, 2>, 2> mAnalyserPaths;
+
+    // the same curves flattened where they are built, so paint only copies them to the GL renderer
+    Polyline::Points mFrequencyPoints;
+    Polyline::Points mPreviousFrequencyPoints;
+    Polyline::Points mPhasePoints;
+    Polyline::Points mGroupDelayPoints;
+    Polyline::Points mBandPhasePoints;
+    Polyline::Points mBandDelayPoints;
+    std::array<std::array<Polyline::Points, 2>, 2> mAnalyserPoints;
+    bool mAnalyserPathsValid = false;
 
     juce::OwnedArray<BandEditor> mBandEditor;
 
     int mDraggingBand = -1;
+    std::vector<int> mMarkerX;
     bool mDraggingGain = false;
 
     juce::OwnedArray<juce::AudioProcessorValueTreeState::SliderAttachment> mAttachments;
     juce::SharedResourcePointer<juce::TooltipWindow> mTooltipWindow;
 
     juce::PopupMenu mContextMenu;
+    std::unique_ptr<juce::FileChooser> mTraceChooser;
+
+    FramePacer mFramePacer{ *this, [this] { updateFrame(); } };
+
+    Gainrev2AudioProcessor::Generations mSeenGenerations{};
+
+    int mLastDroppedBlocks = 0;
+    juce::uint32 mDropWarningUntil = 0;
+    juce::uint32 mNextLoadUpdate = 0;
 
     Gainrev2AudioProcessor& audioProcessor;
 
+    LoadMeterDisplay mLoadMeter{ audioProcessor.getLoadMeter() };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Gainrev2AudioProcessorEditor)
 
 #ifdef JUCE_OPENGL
         juce::OpenGLContext openGLContext;
+
+        SpectrogramRenderer mSpectrogram{ Gainrev2AudioProcessor::spectrogramWidth };
+        std::vector<juce::uint8> mSpectrogramRows;
+
+        juce::SpinLock mGLBoundsLock;
+        juce::Rectangle<int> mGLPlotFrame;
+        int mGLWidth = 0;
+        int mGLHeight = 0;
+
+        CurveRenderer mCurves;
+        std::vector<CurveRenderer::Curve> mGLCurves;
+        size_t mNumGLCurves = 0;
 #endif // JUCE_OPENGL
 
 };
@@ -10,6 +10,8 @@
 #include "PluginEditor.h"
 #include "Analyser.h"
 #include "BandEditor.h"
+#include "RealtimeCheck.h"
+#include "TraceEvents.h"
 
 juce::String Gainrev2AudioProcessor::paramOutput("output");
 juce::String Gainrev2AudioProcessor::paramType("type");
@@ -22,6 +24,14 @@ namespace IDs {
 	juce::String editor{ "editor" };
 	juce::String sizeX{ "size-x" };
 	juce::String sizeY{ "size-y" };
+	juce::String multiResolution{ "multi-resolution" };
+	juce::String channelMode{ "channel-mode" };
+	juce::String spectrogram{ "spectrogram" };
+	juce::String decimation{ "decimation" };
+	juce::String phaseOverlay{ "phase-overlay" };
+	juce::String groupDelayOverlay{ "group-delay-overlay" };
+	juce::String crossfade{ "crossfade" };
+	juce::String soloListen{ "solo-listen" };
 }
 
 juce::String Gainrev2AudioProcessor::getBandID(size_t index)
@@ -172,35 +182,58 @@ Gainrev2AudioProcessor::Gainrev2AudioProcessor()
 #endif
 	mState(*this, &mUndo, "PARAMS", createParameterLayout())
 {
-	mFrequencies.resize(300);
-	for (size_t i = 0; i < mFrequencies.size(); ++i) {
-		mFrequencies[i] = 20.0 * std::pow(2.0, i / 30.0f);
-	}
-	mMagnitudes.resize(mFrequencies.size());
+	// the host's audio thread may record its first event in processBlock
+	TraceEvents::prepare();
 
 	mBands = createDefaultBands();
+	mCachedKeys.resize(mBands.size());
+
+	setResponseResolution(300);
 
 	for (size_t i = 0; i < mBands.size(); ++i)
 	{
-		mBands[i].magnitudes.resize(mFrequencies.size(), 1.0); // check here if error, different magnitudes
-
 		mState.addParameterListener(getTypeParamName(i), this); 
 		mState.addParameterListener(getFrequencyParamName(i), this);
 		mState.addParameterListener(getQualityParamName(i), this);
 		mState.addParameterListener(getGainParamName(i), this);
 		mState.addParameterListener(getActiveParamName(i), this);
 
+		for (const auto& id : { getTypeParamName(i), getFrequencyParamName(i), getQualityParamName(i), getGainParamName(i), getActiveParamName(i) })
+			mParameterBands.set(id, int(i));
+
+		mBandValues.push_back({ mState.getRawParameterValue(getTypeParamName(i)),
+			mState.getRawParameterValue(getFrequencyParamName(i)),
+			mState.getRawParameterValue(getQualityParamName(i)),
+			mState.getRawParameterValue(getGainParamName(i)),
+			mState.getRawParameterValue(getActiveParamName(i)) });
 	}
 
 	mState.addParameterListener(paramOutput, this);
+	mOutputValue = mState.getRawParameterValue(paramOutput);
+
+	for (const auto& id : getStateParameterIDs())
+	{
+		mStateParameters.push_back(mState.getParameter(id));
+		mStateValues.push_back(mState.getRawParameterValue(id));
+	}
+	// a new parameter needs a new StateFormat version
+	jassert(int(mStateParameters.size()) == StateFormat::getNumParameters(StateFormat::currentVersion));
+
+	// biquads from the start, see AudioSnapshot
+	for (auto& filter : mBandFilters)
+		*filter.state = juce::dsp::IIR::Coefficients<float>(1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+	*mListenFilter.state = juce::dsp::IIR::Coefficients<float>(1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+
+	mOverlays.onCurvesReady = [this] { updatePlots(overlaysChanged); };
 
 	mState.state = juce::ValueTree(JucePlugin_Name);
 }
 
 Gainrev2AudioProcessor::~Gainrev2AudioProcessor()
 {
-	mAnalyserInput.stopThread(1000);
-	mAnalyserOutput.stopThread(1000);
+	cancelPendingUpdate();
+	mAnalyserInput.stopAnalysis();
+	mAnalyserOutput.stopAnalysis();
 }
 
 //==============================================================================
@@ -265,95 +298,264 @@ void Gainrev2AudioProcessor::changeProgramName(int index, const juce::String& ne
 {
 }
 
+juce::dsp::IIR::Coefficients<float>::Ptr Gainrev2AudioProcessor::makeCoefficients(FilterType type, double sampleRate, float frequency, float quality, float gain)
+{
+	switch (type)
+	{
+	case NoFilter:
+		return new juce::dsp::IIR::Coefficients<float>(1, 0, 1, 0);
+	case LowPass:
+		return juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, frequency, quality);
+	case LowPass1st:
+		return juce::dsp::IIR::Coefficients<float>::makeFirstOrderLowPass(sampleRate, frequency);
+	case LowShelf:
+		return juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, frequency, quality, gain);
+	case BandPass:
+		return juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, frequency, quality);
+	case AllPass:
+		return juce::dsp::IIR::Coefficients<float>::makeAllPass(sampleRate, frequency, quality);
+	case AllPass1st:
+		return juce::dsp::IIR::Coefficients<float>::makeFirstOrderAllPass(sampleRate, frequency);
+	case Notch:
+		return juce::dsp::IIR::Coefficients<float>::makeNotch(sampleRate, frequency, quality);
+	case Peak:
+		return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, frequency, quality, gain);
+	case HighShelf:
+		return juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, frequency, quality, gain);
+	case HighPass1st:
+		return juce::dsp::IIR::Coefficients<float>::makeFirstOrderHighPass(sampleRate, frequency);
+	case HighPass:
+		return juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, frequency, quality);
+	case LastFilterID:
+	default:
+		break;
+	}
+	return nullptr;
+}
+
+BiquadDesign::Coefficients Gainrev2AudioProcessor::designBand(FilterType type, double sampleRate, float frequency, float quality, float gain)
+{
+	switch (type)
+	{
+	case LowPass:
+		return BiquadDesign::lowPass(sampleRate, frequency, quality);
+	case LowPass1st:
+		return BiquadDesign::firstOrderLowPass(sampleRate, frequency);
+	case LowShelf:
+		return BiquadDesign::lowShelf(sampleRate, frequency, quality, gain);
+	case BandPass:
+		return BiquadDesign::bandPass(sampleRate, frequency, quality);
+	case AllPass:
+		return BiquadDesign::allPass(sampleRate, frequency, quality);
+	case AllPass1st:
+		return BiquadDesign::firstOrderAllPass(sampleRate, frequency);
+	case Notch:
+		return BiquadDesign::notch(sampleRate, frequency, quality);
+	case Peak:
+		return BiquadDesign::peak(sampleRate, frequency, quality, gain);
+	case HighShelf:
+		return BiquadDesign::highShelf(sampleRate, frequency, quality, gain);
+	case HighPass1st:
+		return BiquadDesign::firstOrderHighPass(sampleRate, frequency);
+	case HighPass:
+		return BiquadDesign::highPass(sampleRate, frequency, quality);
+	case NoFilter:
+	case LastFilterID:
+	default:
+		break;
+	}
+	return BiquadDesign::identity();
+}
+
+Gainrev2AudioProcessor::BandParameters Gainrev2AudioProcessor::getBandParameters(size_t index) const
+{
+	const auto& values = mBandValues[index];
+	return { static_cast<FilterType>(juce::roundToInt(values.type->load())),
+		values.frequency->load(),
+		values.quality->load(),
+		values.gain->load(),
+		values.active->load() >= 0.5f };
+}
+
 void Gainrev2AudioProcessor::updateBand(const size_t index)
 {
-	if (mSampleRate > 0)
+	mDirty.fetch_or(juce::uint32(1) << index);
+	publishAudioSnapshot();
+}
+
+void Gainrev2AudioProcessor::publishAudioSnapshot()
+{
+	EQ_TRACE_SCOPE("publishAudioSnapshot");
+
+	if (mBatchingUpdates.load())
+		return;     // restoreParameters() publishes once it's done
+
+	// a thread that finds the lock taken leaves its bits to the holder, which
+	// checks for more after letting go, so nothing waits and nothing is lost.
+	// Hosts may automate on the audio thread, so nothing in here allocates.
+	while (mDirty.load() != 0)
 	{
-		juce::dsp::IIR::Coefficients<float>::Ptr newCoefficients;
-		switch (mBands[index].type)
-		{
-		case NoFilter:
-			newCoefficients = new juce::dsp::IIR::Coefficients<float>(1, 0, 1, 0);
-			break;
-		case LowPass:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(mSampleRate, mBands[index].frequency, mBands[index].quality);
-			break;
-		case LowPass1st:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeFirstOrderLowPass(mSampleRate, mBands[index].frequency);
-			break;
-		case LowShelf:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(mSampleRate, mBands[index].frequency, mBands[index].quality, mBands[index].gain);
-			break;
-		case BandPass:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(mSampleRate, mBands[index].frequency, mBands[index].quality);
-			break;
-		case AllPass:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(mSampleRate, mBands[index].frequency, mBands[index].quality);
-			break;
-		case AllPass1st:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeFirstOrderAllPass(mSampleRate, mBands[index].frequency);
-			break;
-		case Notch:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeNotch(mSampleRate, mBands[index].frequency, mBands[index].quality);
-			break;
-		case Peak:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(mSampleRate, mBands[index].frequency, mBands[index].quality, mBands[index].gain);
-			break;
-		case HighShelf:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeHighShelf(mSampleRate, mBands[index].frequency, mBands[index].quality, mBands[index].gain);
-			break;
-		case HighPass1st:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeFirstOrderHighPass(mSampleRate, mBands[index].frequency);
-			break;
-		case HighPass:
-			newCoefficients = juce::dsp::IIR::Coefficients<float>::makeHighPass(mSampleRate, mBands[index].frequency, mBands[index].quality);
-			break;
-		case LastFilterID:
-		default:
-			break;
-		}
+		const juce::SpinLock::ScopedTryLockType publishLock(mPublishLock);
+		if (!publishLock.isLocked())
+			return;
+
+		const auto dirty = mDirty.exchange(0);
+		const auto sampleRate = mSampleRate.load();
+		if (sampleRate <= 0)
+			return;     // prepareToPlay() publishes everything
 
-		if (newCoefficients)
+		const auto solo = mSolo.load();
+		const auto soloed = juce::isPositiveAndBelow(solo, mBands.size());
+		const auto listening = soloed && mSoloListen.load();
+		juce::uint32 changedBands = 0;
+
+		for (size_t i = 0; i < mBands.size(); ++i)
 		{
+			const auto band = getBandParameters(i);
+
+			if ((dirty & (juce::uint32(1) << i)) != 0)
 			{
-				juce::ScopedLock processLock(getCallbackLock());
-				if (index == 0)
-					*mFilter.get<0>().state = *newCoefficients;
-				else if (index == 1)
-					*mFilter.get<1>().state = *newCoefficients;
-				else if (index == 2)
-					*mFilter.get<2>().state = *newCoefficients;
-				else if (index == 3)
-					*mFilter.get<3>().state = *newCoefficients;
-				else if (index == 4)
-					*mFilter.get<4>().state = *newCoefficients;
-				else if (index == 5)
-					*mFilter.get<5>().state = *newCoefficients;
+				mNextSnapshot.coefficients[i] = designBand(band.type, sampleRate, band.frequency, band.quality, band.gain);
+				mNextResponses[i].section = ResponseEvaluator::Section::fromBiquad(mNextSnapshot.coefficients[i].data());
+				mNextResponses[i].key = { band.type, band.frequency, band.quality, band.gain, sampleRate };
+				changedBands |= juce::uint32(1) << i;
 			}
-			newCoefficients->getMagnitudeForFrequencyArray(mFrequencies.data(), mBands[index].magnitudes.data(), mFrequencies.size(), mSampleRate);
+
+			mNextSnapshot.enabled[i] = soloed ? solo == int(i) && !listening : band.active;
+		}
+
+		if (listening)
+		{
+			const auto band = getBandParameters(size_t(solo));
+			mNextSnapshot.listenCoefficients = designBand(BandPass, sampleRate, band.frequency, band.quality, 1.0f);
+		}
+		mNextSnapshot.listening = listening;
+		mNextSnapshot.outputGain = mOutputValue->load();
+
+		mAudioSnapshot.getWriteBuffer() = mNextSnapshot;
+		mAudioSnapshot.publish();
+
+		if (changedBands != 0)
+		{
+			mBandResponses.getWriteBuffer() = mNextResponses;
+			mBandResponses.publish();
 		}
-		updateBypassedStates();
-		updatePlots();
+
+		updatePlots(changedBands);
 	}
 }
 
-void Gainrev2AudioProcessor::updatePlots()
+void Gainrev2AudioProcessor::applyAudioSnapshot(const AudioSnapshot& snapshot)
+{
+	// the filters share their coefficients with the per channel processors, and
+	// every one of them holds five values, so this is a plain copy
+	for (size_t i = 0; i < mBandFilters.size(); ++i)
+		std::copy(snapshot.coefficients[i].begin(), snapshot.coefficients[i].end(), mBandFilters[i].state->getRawCoefficients());
+	std::copy(snapshot.listenCoefficients.begin(), snapshot.listenCoefficients.end(), mListenFilter.state->getRawCoefficients());
+
+	mOutputGain.setGainLinear(snapshot.outputGain);
+}
+
+void Gainrev2AudioProcessor::updatePlots(juce::uint32 changes)
 {
-	auto gain = mFilter.get<6>().getGainLinear();
-	std::fill(mMagnitudes.begin(), mMagnitudes.end(), gain);
+	// the curves themselves are evaluated lazily in updateResponses(), the
+	// editor picks the bumped generations up on its next frame
+	for (size_t bit = 0; changes != 0; ++bit, changes >>= 1)
+		if ((changes & 1u) != 0)
+			mGenerations[bit].fetch_add(1, std::memory_order_release);
+}
 
-	if (juce::isPositiveAndBelow(mSolo, mBands.size()))
+juce::uint32 Gainrev2AudioProcessor::getChangesSince(Generations& seen) const
+{
+	juce::uint32 changes = 0;
+	for (size_t bit = 0; bit < seen.size(); ++bit)
 	{
-		juce::FloatVectorOperations::multiply(mMagnitudes.data(), mBands[size_t(mSolo)].magnitudes.data(), static_cast<int>(mMagnitudes.size()));
+		const auto generation = mGenerations[bit].load(std::memory_order_acquire);
+		if (generation != seen[bit])
+		{
+			seen[bit] = generation;
+			changes |= juce::uint32(1) << bit;
+		}
 	}
-	else
+	return changes;
+}
+
+void Gainrev2AudioProcessor::updateResponses()
+{
+	const auto sampleRate = mSampleRate.load();
+	if (sampleRate <= 0)
+		return;
+
+	mBandResponses.pull();
+	const auto& responses = mBandResponses.read();
+
+	if (mResponse.getSampleRate() != sampleRate || mResponse.getNumPoints() != int(mFrequencies.size()))
 	{
-		for (size_t i = 0; i < mBands.size(); ++i)
-			if (mBands[i].active)
-				juce::FloatVectorOperations::multiply(mMagnitudes.data(), mBands[i].magnitudes.data(), static_cast<int>(mMagnitudes.size()));
+		mResponse.prepare(mFrequencies, sampleRate);
+		std::fill(mCachedKeys.begin(), mCachedKeys.end(), ResponseKey());
+		mCompositeValid = false;
+	}
+
+	// the composite is a running sum, so a band only touches it when its curve
+	// or its contribution changed; a new grid starts it from scratch
+	if (!mCompositeValid)
+	{
+		std::fill(mCompositeDB.begin(), mCompositeDB.end(), 0.0);
+		mCompositeBands = 0;
+		mCompositeGainDB = 0;
+		mCompositeValid = true;
 	}
 
-	sendChangeMessage();
+	juce::uint32 evaluateMask = 0;
+	juce::uint32 contributing = 0;
+	const auto solo = mSolo.load();
+	std::vector<ResponseEvaluator::Section> sections;
+	std::vector<double*> curves;
+	for (size_t i = 0; i < mBands.size(); ++i)
+	{
+		if (responses[i].key != mCachedKeys[i])
+		{
+			evaluateMask |= juce::uint32(1) << i;
+			mCachedKeys[i] = responses[i].key;
+		}
+
+		sections.push_back(responses[i].section);
+		curves.push_back(mBands[i].responseDB.data());
+		if (juce::isPositiveAndBelow(solo, mBands.size()) ? solo == int(i) : getBandParameters(i).active)
+			contributing |= juce::uint32(1) << i;
+	}
+
+	const auto removeMask = mCompositeBands & (evaluateMask | ~contributing);
+	const auto addMask = contributing & (evaluateMask | ~mCompositeBands);
+	const auto gainDB = juce::Decibels::gainToDecibels(double(mOutputValue->load()), ResponseEvaluator::floorDB);
+
+	mResponse.process(sections.data(), curves.data(), int(sections.size()),
+		evaluateMask, removeMask, addMask, gainDB - mCompositeGainDB, mCompositeDB.data());
+
+	mCompositeBands = contributing;
+	mCompositeGainDB = gainDB;
+
+	mOverlays.request(mFrequencies, sampleRate, sections, contributing);
+}
+
+void Gainrev2AudioProcessor::setResponseResolution(int numPoints)
+{
+	numPoints = juce::jlimit(32, 4096, numPoints);
+	if (numPoints == int(mFrequencies.size()))
+		return;
+
+	// same ten octaves from 20 Hz as before, just sampled at the plot's width
+	mFrequencies.resize(size_t(numPoints));
+	for (size_t i = 0; i < mFrequencies.size(); ++i)
+		mFrequencies[i] = 20.0 * std::pow(2.0, 10.0 * double(i) / double(numPoints));
+
+	mCompositeDB.resize(mFrequencies.size());
+	for (auto& band : mBands)
+		band.responseDB.assign(mFrequencies.size(), 0.0);
+	std::fill(mCachedKeys.begin(), mCachedKeys.end(), ResponseKey());
+	mCompositeValid = false;
+
+	updateResponses();
 }
 
 //==============================================================================
@@ -361,7 +563,7 @@ void Gainrev2AudioProcessor::prepareToPlay(double sampleRate, int samplesPerBloc
 {
 	// Use this method as the place to do any pre-playback
 	// initialisation that you need..
-	mSampleRate = sampleRate;
+	mSampleRate.store(sampleRate);
 
 	juce::dsp::ProcessSpec spec;
 
@@ -369,27 +571,48 @@ void Gainrev2AudioProcessor::prepareToPlay(double sampleRate, int samplesPerBloc
 	spec.maximumBlockSize = uint32_t(samplesPerBlock);
 	spec.numChannels = uint32_t(getTotalNumOutputChannels());
 
-	for (size_t i = 0; i < mBands.size(); ++i)
-	{
-		updateBand(i);
-	}
-	mFilter.get<6>().setGainLinear(*mState.getRawParameterValue(paramOutput));
+	mDirty.fetch_or(switchesDirty | ((juce::uint32(1) << mBands.size()) - 1));
+	publishAudioSnapshot();
+
+	updatePlots(globalChanged);
 
-	updatePlots();
+	// playback is stopped, so this is the one place besides the audio thread that may take the snapshot
+	mAudioSnapshot.pull();
+	applyAudioSnapshot(mAudioSnapshot.read());
 
-	mFilter.prepare(spec);
+	for (auto& filter : mBandFilters)
+		filter.prepare(spec);
+	mListenFilter.prepare(spec);
+	mOutputGain.prepare(spec);
+
+	mWetBuffer.setSize(int(spec.numChannels), samplesPerBlock);
+	mDryBuffer.setSize(int(spec.numChannels), samplesPerBlock);
+	mFadeGains.resize(size_t(samplesPerBlock));
+
+	// start where the switches are rather than fading in from silence
+	const auto& snapshot = mAudioSnapshot.read();
+	for (size_t i = 0; i < mBandFades.size(); ++i)
+	{
+		mBandFades[i].setTarget(snapshot.enabled[i]);
+		mBandFades[i].skip();
+	}
+	mListenFade.setTarget(snapshot.listening);
+	mListenFade.skip();
+	mBypassFade.setTarget(true);
+	mBypassFade.skip();
 
 	//visualiser.clear();
 
 	mAnalyserInput.setupAnalyser(int(sampleRate), float(sampleRate));
 	mAnalyserOutput.setupAnalyser(int(sampleRate), float(sampleRate));
 
+	mLoadMeter.prepare(sampleRate);
+	mLoadMeter.reset();
 }
 
 void Gainrev2AudioProcessor::releaseResources()
 {
-	mAnalyserInput.stopThread(1000);
-	mAnalyserOutput.stopThread(1000);
+	// the analysers follow the editor's lifetime, see setAnalysersActive()
 	// When playback stops, you can use this as an opportunity to free up any
 	// spare memory, etc.
 }
@@ -422,76 +645,168 @@ bool Gainrev2AudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts)
 
 void Gainrev2AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-	juce::ScopedNoDenormals noDenormals;
+	const RealtimeCheck::ScopedRealtime realtime;
+	const LoadMeter::ScopedMeasurement loadMeasurement(mLoadMeter, buffer.getNumSamples());
+	EQ_TRACE_SCOPE("processBlock");
+	juce::ignoreUnused(midiMessages);
+
+	process(buffer, false);
+}
+
+void Gainrev2AudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+	const RealtimeCheck::ScopedRealtime realtime;
+	const LoadMeter::ScopedMeasurement loadMeasurement(mLoadMeter, buffer.getNumSamples());
+	EQ_TRACE_SCOPE("processBlockBypassed");
 	juce::ignoreUnused(midiMessages);
+
+	process(buffer, true);
+}
+
+void Gainrev2AudioProcessor::process(juce::AudioBuffer<float>& buffer, bool bypassed)
+{
+	juce::ScopedNoDenormals noDenormals;
 	auto totalNumInputChannels = getTotalNumInputChannels();
 	auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-	if (getActiveEditor() != nullptr)
-	{
-		mAnalyserInput.addAudioData(buffer, 0, totalNumInputChannels);
-	}
+	mAnalyserInput.addAudioData(buffer, 0, totalNumInputChannels);
 
 	// In case we have more outputs than inputs, this code clears any output
 	// channels that didn't contain input data, (because these aren't
 	// guaranteed to be empty - they may contain garbage).
-	// This is here to avoid people getting screaming feedback
-	// when they first compile a plugin, but obviously you don't need to keep
-	// this code if your algorithm always overwrites all the output channels.
+	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+		buffer.clear(i, 0, buffer.getNumSamples());
+
+	if (mAudioSnapshot.pull())
+		applyAudioSnapshot(mAudioSnapshot.read());
 
-	if (mWasBypassed)
+	const auto& snapshot = mAudioSnapshot.read();
+	const auto fadeLength = juce::roundToInt(mCrossfadeTime.load(std::memory_order_relaxed) * mSampleRate.load(std::memory_order_relaxed));
+	mBypassFade.setLength(fadeLength);
+	mBypassFade.setTarget(!bypassed);
+	for (size_t i = 0; i < mBandFades.size(); ++i)
 	{
-		mFilter.reset();
-		mWasBypassed = false;
+		mBandFades[i].setLength(fadeLength);
+		mBandFades[i].setTarget(snapshot.enabled[i]);
 	}
+	mListenFade.setLength(fadeLength);
+	mListenFade.setTarget(snapshot.listening);
 
+	// the scratch buffers hold one prepared block, hosts that send more get it in pieces
+	const auto chunkSize = size_t(mWetBuffer.getNumSamples());
+	const auto numChannels = juce::jmin(size_t(buffer.getNumChannels()), size_t(mWetBuffer.getNumChannels()));
+	if (chunkSize > 0 && numChannels > 0)
+	{
+		auto ioBlock = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, numChannels);
+		for (size_t start = 0; start < ioBlock.getNumSamples(); start += chunkSize)
+			processChunk(ioBlock.getSubBlock(start, juce::jmin(chunkSize, ioBlock.getNumSamples() - start)));
+	}
 
-	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-		buffer.clear(i, 0, buffer.getNumSamples());
+	mAnalyserOutput.addAudioData(buffer, 0, totalNumOutputChannels);
+}
+
+void Gainrev2AudioProcessor::processChunk(juce::dsp::AudioBlock<float> block)
+{
+	const auto numChannels = block.getNumChannels();
+	const auto numSamples = block.getNumSamples();
+
+	// bypassed or not the filters run, so their state is current whenever the bypass fades back in
+	const auto bypassFading = !mBypassFade.isOn();
+	auto dry = juce::dsp::AudioBlock<float>(mDryBuffer).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+	if (bypassFading)
+		dry.copyFrom(block);
 
-	// This is the place where you'd normally do the guts of your plugin's
-	// audio processing...
-	// Make sure to reset the state if your inner loop is processing
-	// the samples and the outer loop is handling the channels.
-	// Alternatively, you can process the samples with the channels
-	// interleaved by keeping the same state.
+	for (size_t i = 0; i < mBandFilters.size(); ++i)
+		processFilter(mBandFilters[i], mBandFades[i], block);
+	processFilter(mListenFilter, mListenFade, block);
 
-	for (int channel = 0; channel < totalNumInputChannels; ++channel)
+	juce::dsp::ProcessContextReplacing<float> context(block);
+	mOutputGain.process(context);
+
+	if (mBypassFade.isOff())
+	{
+		block.copyFrom(dry);
+	}
+	else if (bypassFading)
 	{
-		auto* channelData = buffer.getWritePointer(channel);
-		const auto readPointer = buffer.getReadPointer(channel);
+		mBypassFade.getNextGains(mFadeGains.data(), int(numSamples));
+		CrossfadeRamp::mix(block, dry, block, mFadeGains.data());
+	}
+}
 
-		for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-		{
-			//channelData[sample] = channelData[sample] * juce::Decibels::decibelsToGain(mGain);
-		}
+void Gainrev2AudioProcessor::processFilter(FilterBand& filter, CrossfadeRamp& fade, juce::dsp::AudioBlock<float>& block)
+{
+	if (fade.isOff())
+		return;
 
+	if (fade.isOn())
+	{
+		juce::dsp::ProcessContextReplacing<float> context(block);
+		filter.process(context);
+		return;
 	}
-	juce::dsp::AudioBlock<float> ioBuffer(buffer);
-	juce::dsp::ProcessContextReplacing<float> context(ioBuffer);
 
-	mFilter.process(context);
-	if (getActiveEditor() != nullptr)
-		mAnalyserOutput.addAudioData(buffer, 0, totalNumOutputChannels);
+	// a band fading in starts from a clean state, not from wherever it was when it went off
+	if (fade.isSilent())
+		filter.reset();
+
+	auto wet = juce::dsp::AudioBlock<float>(mWetBuffer).getSubsetChannelBlock(0, block.getNumChannels()).getSubBlock(0, block.getNumSamples());
+	wet.copyFrom(block);
+	juce::dsp::ProcessContextReplacing<float> context(wet);
+	filter.process(context);
+
+	fade.getNextGains(mFadeGains.data(), int(block.getNumSamples()));
+	CrossfadeRamp::mix(block, block, wet, mFadeGains.data());
 }
 
-void Gainrev2AudioProcessor::createFrequencyPlot(juce::Path& p, const std::vector<double>& mags, const juce::Rectangle<int> bounds, float pixelsPerDouble)
+void Gainrev2AudioProcessor::createFrequencyPlot(juce::Path& p, const std::vector<double>& curveDB, const juce::Rectangle<int> bounds, float pixelsPerDB)
 {
-	p.startNewSubPath(float(bounds.getX()), mags[0] > 0 ? float(bounds.getCentreY() - pixelsPerDouble * std::log(mags[0]) / std::log(2.0)) : bounds.getBottom());
+	// curves are already in dB, anything at the floor is a notch zero and drops to the bottom
+	const auto yForDB = [&](double dB)
+	{
+		return dB > ResponseEvaluator::floorDB ? float(bounds.getCentreY() - pixelsPerDB * dB) : float(bounds.getBottom());
+	};
+
+	p.startNewSubPath(float(bounds.getX()), yForDB(curveDB[0]));
 
 	const auto xFactor = static_cast<double>(bounds.getWidth()) / mFrequencies.size();
 	for (size_t i = 1; i < mFrequencies.size(); ++i) //change to cubicTo?
 	{
-		p.lineTo(float(bounds.getX() + i * xFactor), float(mags[i] > 0 ? bounds.getCentreY() - pixelsPerDouble * std::log(mags[i]) / std::log(2.0) : bounds.getBottom()));
+		p.lineTo(float(bounds.getX() + i * xFactor), yForDB(curveDB[i]));
 	}
 }
 
-void Gainrev2AudioProcessor::createAnalyserPlot(juce::Path& p, const juce::Rectangle<int> bounds, float minFreq, bool input)
+void Gainrev2AudioProcessor::createAnalyserPlot(juce::Path& p, const juce::Rectangle<int> bounds, float minFreq, bool input, int trace)
 {
 	if (input)
-		mAnalyserInput.createPath(p, bounds.toFloat(), minFreq);
+		mAnalyserInput.createPath(p, bounds.toFloat(), minFreq, trace);
+	else
+		mAnalyserOutput.createPath(p, bounds.toFloat(), minFreq, trace);
+}
+
+void Gainrev2AudioProcessor::setAnalyserPlotBounds(const juce::Rectangle<int> bounds, float minFreq)
+{
+	mAnalyserInput.setPlotBounds(bounds.toFloat(), minFreq);
+	mAnalyserOutput.setPlotBounds(bounds.toFloat(), minFreq);
+}
+
+bool Gainrev2AudioProcessor::swapAnalyserPlot(juce::Path& p, Polyline::Points& points, bool input, int trace)
+{
+	return input ? mAnalyserInput.swapPath(p, points, trace) : mAnalyserOutput.swapPath(p, points, trace);
+}
+
+void Gainrev2AudioProcessor::setAnalysersActive(bool shouldBeActive)
+{
+	if (shouldBeActive)
+	{
+		mAnalyserInput.startAnalysis();
+		mAnalyserOutput.startAnalysis();
+	}
 	else
-		mAnalyserOutput.createPath(p, bounds.toFloat(), minFreq);
+	{
+		mAnalyserInput.stopAnalysis();
+		mAnalyserOutput.stopAnalysis();
+	}
 }
 
 bool Gainrev2AudioProcessor::checkForNewAnalyserData()
@@ -499,6 +814,79 @@ bool Gainrev2AudioProcessor::checkForNewAnalyserData()
 	return mAnalyserInput.checkDataAvailable() || mAnalyserOutput.checkDataAvailable();
 }
 
+void Gainrev2AudioProcessor::setAnalyserMultiResolution(bool shouldUseMultiResolution)
+{
+	mAnalyserInput.setMultiResolution(shouldUseMultiResolution);
+	mAnalyserOutput.setMultiResolution(shouldUseMultiResolution);
+}
+
+bool Gainrev2AudioProcessor::getAnalyserMultiResolution() const
+{
+	return mAnalyserOutput.isMultiResolution();
+}
+
+void Gainrev2AudioProcessor::setAnalyserChannelMode(AnalyserChannelMode mode)
+{
+	mAnalyserInput.setChannelMode(mode);
+	mAnalyserOutput.setChannelMode(mode);
+}
+
+AnalyserChannelMode Gainrev2AudioProcessor::getAnalyserChannelMode() const
+{
+	return mAnalyserOutput.getChannelMode();
+}
+
+int Gainrev2AudioProcessor::getAnalyserNumTraces(bool input)
+{
+	return input ? mAnalyserInput.getNumTraces() : mAnalyserOutput.getNumTraces();
+}
+
+StereoReadout Gainrev2AudioProcessor::getStereoReadout()
+{
+	return mAnalyserOutput.getStereoReadout();
+}
+
+LoadMeter& Gainrev2AudioProcessor::getLoadMeter()
+{
+	return mLoadMeter;
+}
+
+void Gainrev2AudioProcessor::setSpectrogramEnabled(bool shouldBeEnabled)
+{
+	mAnalyserOutput.setSpectrogramEnabled(shouldBeEnabled);
+}
+
+bool Gainrev2AudioProcessor::getSpectrogramEnabled() const
+{
+	return mAnalyserOutput.isSpectrogramEnabled();
+}
+
+int Gainrev2AudioProcessor::readSpectrogramRows(juce::uint8* dest, int maxRows)
+{
+	return mAnalyserOutput.readSpectrogramRows(dest, maxRows);
+}
+
+void Gainrev2AudioProcessor::setAnalyserDecimation(int factor)
+{
+	mAnalyserInput.setDecimation(factor);
+	mAnalyserOutput.setDecimation(factor);
+}
+
+int Gainrev2AudioProcessor::getAnalyserDecimation() const
+{
+	return mAnalyserOutput.getDecimation();
+}
+
+int Gainrev2AudioProcessor::getMaxAnalyserDecimation() const
+{
+	return Analyser<float>::getMaxDecimation(getSampleRate());
+}
+
+int Gainrev2AudioProcessor::getAnalyserDroppedBlocks() const
+{
+	return mAnalyserInput.getNumDroppedBlocks() + mAnalyserOutput.getNumDroppedBlocks();
+}
+
 juce::AudioProcessorValueTreeState& Gainrev2AudioProcessor::getPluginState()
 {
 	return mState;
@@ -529,56 +917,43 @@ juce::String Gainrev2AudioProcessor::getActiveParamName(size_t index)
 	return getBandID(index) + "-" + paramActive;
 }
 
-int Gainrev2AudioProcessor::getBandIndexFromID(juce::String paramID)
+int Gainrev2AudioProcessor::getBandIndexFromID(const juce::String& paramID) const
 {
-	for (size_t i = 0; i < 6; ++i)
-		if (paramID.startsWith(getBandID(i) + "-"))
-			return int(i);
-	return -1;
+	return mParameterBands.contains(paramID) ? mParameterBands[paramID] : -1;
 }
 
 Gainrev2AudioProcessor::Band* Gainrev2AudioProcessor::getBand(size_t index) {
 	if (juce::isPositiveAndBelow(index, mBands.size()))
-		return &mBands[index];
+	{
+		auto& band = mBands[index];
+		const auto parameters = getBandParameters(index);
+		band.type = parameters.type;
+		band.frequency = parameters.frequency;
+		band.quality = parameters.quality;
+		band.gain = parameters.gain;
+		band.active = parameters.active;
+		return &band;
+	}
 	return nullptr;
 }
 
 void Gainrev2AudioProcessor::parameterChanged(const juce::String& parameter, float newValue)
 {
+	juce::ignoreUnused(newValue);
+
+	// automation may arrive on any thread, the new value is read back from the
+	// parameter's atomic when the snapshot is built
 	if (parameter == paramOutput)
 	{
-		mFilter.get<6>().setGainLinear(newValue);
-		updatePlots();
+		mDirty.fetch_or(switchesDirty);
+		publishAudioSnapshot();
+		updatePlots(compositeChanged);
 		return;
 	}
 
-	int index = getBandIndexFromID(parameter);
+	const auto index = getBandIndexFromID(parameter);
 	if (juce::isPositiveAndBelow(index, mBands.size()))
-	{
-		auto* band = getBand(size_t(index));
-		if (parameter.endsWith(paramType))
-		{
-			band->type = static_cast<FilterType>(static_cast<int> (newValue));
-		}
-		else if (parameter.endsWith(paramFrequency))
-		{
-			band->frequency = newValue;
-		}
-		else if (parameter.endsWith(paramQuality))
-		{
-			band->quality = newValue;
-		}
-		else if (parameter.endsWith(paramGain))
-		{
-			band->gain = newValue;
-		}
-		else if (parameter.endsWith(paramActive))
-		{
-			band->active = newValue >= 0.5f;
-		}
-
 		updateBand(size_t(index));
-	}
 }
 
 size_t Gainrev2AudioProcessor::getNumBands() const
@@ -602,40 +977,71 @@ juce::Colour Gainrev2AudioProcessor::getBandColour(size_t index) const
 
 bool Gainrev2AudioProcessor::getBandSolo(int index) const
 {
-	return index == mSolo;
+	return index == mSolo.load();
 }
 
 void Gainrev2AudioProcessor::setBandSolo(int index)
 {
-	mSolo = index;
-	updateBypassedStates();
+	mSolo.store(index);
+	mDirty.fetch_or(switchesDirty);
+	publishAudioSnapshot();
+	updatePlots(globalChanged);
 }
 
-void Gainrev2AudioProcessor::updateBypassedStates()
+void Gainrev2AudioProcessor::setSoloListen(bool shouldListen)
 {
-	if (juce::isPositiveAndBelow(mSolo, mBands.size()))
-	{
-		mFilter.setBypassed<0>(mSolo != 0);
-		mFilter.setBypassed<1>(mSolo != 1);
-		mFilter.setBypassed<2>(mSolo != 2);
-		mFilter.setBypassed<3>(mSolo != 3);
-		mFilter.setBypassed<4>(mSolo != 4);
-		mFilter.setBypassed<5>(mSolo != 5);
-	}
-	else {
-		mFilter.setBypassed<0>(!mBands[0].active);
-		mFilter.setBypassed<1>(!mBands[1].active);
-		mFilter.setBypassed<2>(!mBands[2].active);
-		mFilter.setBypassed<3>(!mBands[3].active);
-		mFilter.setBypassed<4>(!mBands[4].active);
-		mFilter.setBypassed<5>(!mBands[5].active);
-	}
-	updatePlots();
+	mSoloListen.store(shouldListen);
+	mDirty.fetch_or(switchesDirty);
+	publishAudioSnapshot();
+}
+
+bool Gainrev2AudioProcessor::getSoloListen() const
+{
+	return mSoloListen.load();
 }
 
-const std::vector<double>& Gainrev2AudioProcessor::getMagnitudes()
+void Gainrev2AudioProcessor::setCrossfadeTime(double seconds)
 {
-	return mMagnitudes;
+	mCrossfadeTime.store(juce::jlimit(0.0, 0.1, seconds));
+}
+
+double Gainrev2AudioProcessor::getCrossfadeTime() const
+{
+	return mCrossfadeTime.load();
+}
+
+const std::vector<double>& Gainrev2AudioProcessor::getCompositeResponse()
+{
+	return mCompositeDB;
+}
+
+void Gainrev2AudioProcessor::setPhaseOverlay(bool shouldBeShown)
+{
+	mShowPhase = shouldBeShown;
+	mOverlays.setEnabled(mShowPhase || mShowGroupDelay);
+	updatePlots(globalChanged);
+}
+
+bool Gainrev2AudioProcessor::getPhaseOverlay() const
+{
+	return mShowPhase;
+}
+
+void Gainrev2AudioProcessor::setGroupDelayOverlay(bool shouldBeShown)
+{
+	mShowGroupDelay = shouldBeShown;
+	mOverlays.setEnabled(mShowPhase || mShowGroupDelay);
+	updatePlots(globalChanged);
+}
+
+bool Gainrev2AudioProcessor::getGroupDelayOverlay() const
+{
+	return mShowGroupDelay;
+}
+
+bool Gainrev2AudioProcessor::getOverlayCurves(ResponseOverlays::Curves& dest)
+{
+	return mOverlays.getCurves(dest);
 }
 
 //==============================================================================
@@ -650,47 +1056,140 @@ juce::AudioProcessorEditor* Gainrev2AudioProcessor::createEditor()
 }
 
 //==============================================================================
+juce::StringArray Gainrev2AudioProcessor::getStateParameterIDs()
+{
+	juce::StringArray ids{ paramOutput };
+	for (size_t i = 0; i < 6; ++i)
+		ids.addArray({ getTypeParamName(i), getFrequencyParamName(i), getQualityParamName(i), getGainParamName(i), getActiveParamName(i) });
+	return ids;
+}
+
 void Gainrev2AudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-	auto editor = mState.state.getOrCreateChildWithName(IDs::editor, nullptr);
-	editor.setProperty(IDs::sizeX, mEditorSize.x, nullptr);
-	editor.setProperty(IDs::sizeY, mEditorSize.y, nullptr);
-	// You should use this method to store your parameters in the memory block.
-	// You could do that either as raw data, or use the XML or ValueTree classes
-	// as intermediaries to make it easy to save and load complex data.
-	juce::MemoryOutputStream stream(destData, false);
-	mState.state.writeToStream(stream);
+	StateFormat::Contents contents;
+	contents.parameters.reserve(mStateValues.size());
+	for (const auto* value : mStateValues)
+		contents.parameters.push_back(value->load());
+
+	auto& settings = contents.settings;
+	const auto editorSize = getSavedSize();
+	settings.set(IDs::sizeX, editorSize.x);
+	settings.set(IDs::sizeY, editorSize.y);
+	settings.set(IDs::multiResolution, getAnalyserMultiResolution());
+	settings.set(IDs::channelMode, static_cast<int>(getAnalyserChannelMode()));
+	settings.set(IDs::spectrogram, getSpectrogramEnabled());
+	settings.set(IDs::decimation, getAnalyserDecimation());
+	settings.set(IDs::phaseOverlay, getPhaseOverlay());
+	settings.set(IDs::groupDelayOverlay, getGroupDelayOverlay());
+	settings.set(IDs::crossfade, getCrossfadeTime() * 1000.0);
+	settings.set(IDs::soloListen, getSoloListen());
+
+	StateFormat::write(contents, destData);
 }
 
 void Gainrev2AudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+	EQ_TRACE_SCOPE("setStateInformation");
+
+	if (StateFormat::isBinaryState(data, size_t(sizeInBytes)))
+	{
+		// a damaged state leaves everything as it is rather than half restored
+		StateFormat::Contents contents;
+		if (StateFormat::read(data, size_t(sizeInBytes), contents))
+		{
+			restoreParameters(contents.parameters);
+			restoreSettings(contents.settings);
+		}
+		return;
+	}
+
+	// version 0: the whole parameter tree, editor settings in a child of their own
 	juce::ValueTree tree = juce::ValueTree::readFromData(data, size_t(sizeInBytes));
 	if (tree.isValid())
 	{
-		mState.state = tree;
-
-		auto editor = mState.state.getChildWithName(IDs::editor);
+		std::vector<float> values;
+		for (auto* parameter : mStateParameters)
+		{
+			const auto child = tree.getChildWithProperty("id", parameter->paramID);
+			values.push_back(child.isValid() ? float(child.getProperty("value"))
+				: parameter->convertFrom0to1(parameter->getDefaultValue()));
+		}
+		restoreParameters(values);
 
+		const auto editor = tree.getChildWithName(IDs::editor);
 		if (editor.isValid())
 		{
-			mEditorSize.setX(editor.getProperty(IDs::sizeX, 900));
-			mEditorSize.setY(editor.getProperty(IDs::sizeY, 500));
-
-			if (auto* thisEditor = getActiveEditor())
-				thisEditor->setSize(mEditorSize.x, mEditorSize.y);
+			juce::NamedValueSet settings;
+			for (int i = 0; i < editor.getNumProperties(); ++i)
+				settings.set(editor.getPropertyName(i), editor.getProperty(editor.getPropertyName(i)));
+			restoreSettings(settings);
 		}
 	}
-	// You should use this method to restore your parameters from this memory block,
-	// whose contents will have been created by the getStateInformation() call.
+}
+
+void Gainrev2AudioProcessor::restoreParameters(const std::vector<float>& values)
+{
+	// every parameter that changes calls parameterChanged(), so hold the audio
+	// snapshot back until all of them are in and rebuild it once
+	mBatchingUpdates.store(true);
+
+	for (size_t i = 0; i < mStateParameters.size(); ++i)
+	{
+		auto* parameter = mStateParameters[i];
+
+		// parameters missing from an older state go back to their defaults
+		auto value = parameter->convertFrom0to1(parameter->getDefaultValue());
+		if (i < values.size() && std::isfinite(values[i]))
+			value = parameter->getNormalisableRange().snapToLegalValue(values[i]);
+
+		if (value != mStateValues[i]->load())
+			parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+	}
+
+	mBatchingUpdates.store(false);
+	publishAudioSnapshot();
+}
+
+void Gainrev2AudioProcessor::restoreSettings(const juce::NamedValueSet& settings)
+{
+	if (settings.isEmpty())
+		return;
+
+	setSavedSize({ settings.getWithDefault(IDs::sizeX, 900), settings.getWithDefault(IDs::sizeY, 500) });
+	setAnalyserMultiResolution(settings.getWithDefault(IDs::multiResolution, false));
+	setAnalyserChannelMode(static_cast<AnalyserChannelMode>(juce::jlimit(0, 2, int(settings.getWithDefault(IDs::channelMode, 0)))));
+	setSpectrogramEnabled(settings.getWithDefault(IDs::spectrogram, false));
+	setAnalyserDecimation(settings.getWithDefault(IDs::decimation, 0));
+	setPhaseOverlay(settings.getWithDefault(IDs::phaseOverlay, false));
+	setGroupDelayOverlay(settings.getWithDefault(IDs::groupDelayOverlay, false));
+	setCrossfadeTime(double(settings.getWithDefault(IDs::crossfade, 10.0)) / 1000.0);
+	setSoloListen(settings.getWithDefault(IDs::soloListen, false));
+
+	// hosts may restore from any thread, while the editor is opened and closed on the message thread
+	if (juce::MessageManager::existsAndIsCurrentThread())
+		handleAsyncUpdate();
+	else
+		triggerAsyncUpdate();
+}
+
+void Gainrev2AudioProcessor::handleAsyncUpdate()
+{
+	if (auto* thisEditor = getActiveEditor())
+	{
+		const auto size = getSavedSize();
+		thisEditor->setSize(size.x, size.y);
+	}
 }
 
 juce::Point<int> Gainrev2AudioProcessor::getSavedSize() const
 {
+	const juce::SpinLock::ScopedLockType sizeLock(mEditorSizeLock);
 	return mEditorSize;
 }
 
 void Gainrev2AudioProcessor::setSavedSize(const juce::Point<int>& size)
 {
+	const juce::SpinLock::ScopedLockType sizeLock(mEditorSizeLock);
 	mEditorSize = size;
 }
 
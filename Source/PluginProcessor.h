@@ -10,6 +10,13 @@
 
 #include <JuceHeader.h>
 #include "Analyser.h"
+#include "ResponseEvaluator.h"
+#include "ResponseOverlays.h"
+#include "LoadMeter.h"
+#include "CrossfadeRamp.h"
+#include "TripleBuffer.h"
+#include "StateFormat.h"
+#include "BiquadDesign.h"
 
 
 //class Visualiser : public juce::AudioVisualiserComponent
@@ -29,7 +36,7 @@
 */
 class Gainrev2AudioProcessor : public juce::AudioProcessor,
 	public juce::AudioProcessorValueTreeState::Listener,
-	public juce::ChangeBroadcaster
+	private juce::AsyncUpdater
 {
 public:
 	//==============================================================================
@@ -68,19 +75,56 @@ public:
 	static juce::String getActiveParamName(size_t index);
 
 
-	void createFrequencyPlot(juce::Path& p, const std::vector<double>& mags, const juce::Rectangle<int> bounds, float pixelsPerDouble);
-	void createAnalyserPlot(juce::Path& p, const juce::Rectangle<int> bounds, float minFreq, bool input);
+	void createFrequencyPlot(juce::Path& p, const std::vector<double>& curveDB, const juce::Rectangle<int> bounds, float pixelsPerDB);
+	void createAnalyserPlot(juce::Path& p, const juce::Rectangle<int> bounds, float minFreq, bool input, int trace = 0);
+
+	/** The analysis threads build their paths for these bounds after every frame. */
+	void setAnalyserPlotBounds(const juce::Rectangle<int> bounds, float minFreq);
+	bool swapAnalyserPlot(juce::Path& p, Polyline::Points& points, bool input, int trace = 0);
 	//==============================================================================
 	void prepareToPlay(double sampleRate, int samplesPerBlock) override;
 	void releaseResources() override;
 
+	/** Starts the analysers while an editor is open; stopping them releases
+		all analysis memory and leaves processBlock with a single atomic check.
+	*/
+	void setAnalysersActive(bool shouldBeActive);
 	bool checkForNewAnalyserData();
 
+	void setAnalyserMultiResolution(bool shouldUseMultiResolution);
+	bool getAnalyserMultiResolution() const;
+
+	void setAnalyserChannelMode(AnalyserChannelMode mode);
+	AnalyserChannelMode getAnalyserChannelMode() const;
+	int getAnalyserNumTraces(bool input);
+	StereoReadout getStereoReadout();
+
+	static constexpr int spectrogramWidth = Analyser<float>::spectrogramWidth;
+	void setSpectrogramEnabled(bool shouldBeEnabled);
+	bool getSpectrogramEnabled() const;
+	int readSpectrogramRows(juce::uint8* dest, int maxRows);
+
+	/** 0 picks the pre-decimation factor from the sample rate, otherwise 1, 2 or 4. */
+	void setAnalyserDecimation(int factor);
+	int getAnalyserDecimation() const;
+	/** Largest factor the current sample rate allows, larger requests are limited to it. */
+	int getMaxAnalyserDecimation() const;
+	int getAnalyserDroppedBlocks() const;
+
+	/** How much of its real-time budget processBlock has been using. */
+	LoadMeter& getLoadMeter();
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 	bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 #endif
 
 	void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+	/** Keeps the filters running on a copy of the input, so leaving bypass fades back into warm filters. */
+	void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+	/** How long switching a band, a solo or the bypass fades for. */
+	void setCrossfadeTime(double seconds);
+	double getCrossfadeTime() const;
 
 	void parameterChanged(const juce::String& parameter, float newValue) override;
 
@@ -90,16 +134,56 @@ public:
 	juce::String getBandName(size_t index) const;
 	juce::Colour getBandColour(size_t index) const;
 
+	/** Solo is a monitoring switch: safe from any thread, the audio thread fades to it. */
 	void setBandSolo(int index);
 	bool getBandSolo(int index) const;
 
+	/** While on, a soloed band plays as a band-pass at its frequency and Q instead of its own curve. */
+	void setSoloListen(bool shouldListen);
+	bool getSoloListen() const;
+
 	static juce::StringArray getFilterTypeNames();
 
+	/** The filter a band of the given type and settings runs, nullptr for LastFilterID. */
+	static juce::dsp::IIR::Coefficients<float>::Ptr makeCoefficients(FilterType type, double sampleRate, float frequency, float quality, float gain);
+	/** The same design as makeCoefficients() as a biquad, without allocating. */
+	static BiquadDesign::Coefficients designBand(FilterType type, double sampleRate, float frequency, float quality, float gain);
+
 	//==============================================================================
 	juce::AudioProcessorEditor* createEditor() override;
 	bool hasEditor() const override;
 
-	const std::vector<double>& getMagnitudes();
+	/** Change flags for getChangesSince(). Bit n marks band n. */
+	static constexpr juce::uint32 compositeChanged = 1u << 29;
+	static constexpr juce::uint32 overlaysChanged = 1u << 30;
+	static constexpr juce::uint32 globalChanged = 1u << 31;
+
+	/** One generation counter per change flag. Readers keep their own copy of
+		the counters they last saw, so any number of editors can poll the
+		processor without taking changes away from each other.
+	*/
+	using Generations = std::array<juce::uint32, 32>;
+
+	/** Returns the flags whose generation moved since seen and updates seen. */
+	juce::uint32 getChangesSince(Generations& seen) const;
+
+	/** Re-evaluates the band responses that changed since the last call and
+		updates the composite. Called from the editor at most once per frame
+		rather than once per parameter change.
+	*/
+	void updateResponses();
+
+	/** Resamples the response grid so it has one point per pixel of the plot. */
+	void setResponseResolution(int numPoints);
+	/** Sum of the contributing band curves and the output gain, in dB. */
+	const std::vector<double>& getCompositeResponse();
+
+	/** Phase and group delay are calculated in the background while either overlay is shown. */
+	void setPhaseOverlay(bool shouldBeShown);
+	bool getPhaseOverlay() const;
+	void setGroupDelayOverlay(bool shouldBeShown);
+	bool getGroupDelayOverlay() const;
+	bool getOverlayCurves(ResponseOverlays::Curves& dest);
 	//==============================================================================
 	const juce::String getName() const override;
 
@@ -117,8 +201,16 @@ public:
 
 	//==============================================================================
 	void getStateInformation(juce::MemoryBlock& destData) override;
+	/** Reads the binary StateFormat or the ValueTree older versions saved. Only
+		parameters that differ from the current values are set, and the audio
+		snapshot is rebuilt once afterwards.
+	*/
 	void setStateInformation(const void* data, int sizeInBytes) override;
 
+	/** The order parameters are saved in. Only ever append to it, see StateFormat. */
+	static juce::StringArray getStateParameterIDs();
+
+	/** Any thread. A restored size is applied to an open editor on the message thread. */
 	juce::Point<int> getSavedSize() const;
 	void setSavedSize(const juce::Point<int>& size);
 
@@ -144,22 +236,66 @@ public:
 		float       quality = 1.0f;
 		float       gain = 1.0f;
 		bool        active = true;
-		std::vector<double> magnitudes;
+		std::vector<double> responseDB;
 	};
 
+	/** The GUI's model of a band, for the message thread only. The settings are
+		refreshed from the parameters on every call, the audio thread never sees it.
+	*/
 	Band* getBand(size_t index);
-	int getBandIndexFromID(juce::String paramID);
+	/** Looks the ID up in a table built by the constructor, so it neither allocates nor locks. */
+	int getBandIndexFromID(const juce::String& paramID) const;
 
 private:
 	
 	Analyser<float> mAnalyserInput;
 	Analyser<float> mAnalyserOutput;
 	
+	/** A band's settings as one value, read from the parameters' atomics. */
+	struct BandParameters
+	{
+		FilterType type = NoFilter;
+		float frequency = 1000.0f;
+		float quality = 1.0f;
+		float gain = 1.0f;
+		bool active = true;
+	};
+
+	BandParameters getBandParameters(size_t index) const;
+
+	using FilterBand = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
+	using Gain = juce::dsp::Gain<float>;
+
+	/** Everything the audio thread runs, built off the audio thread and never changed
+		once published. Every filter is a biquad, first order ones with zeros in the
+		second order terms, so applying new coefficients never resizes filter state.
+	*/
+	struct AudioSnapshot
+	{
+		std::array<std::array<float, 5>, 6> coefficients{};
+		std::array<bool, 6> enabled{};
+		std::array<float, 5> listenCoefficients{};
+		bool listening = false;
+		float outputGain = 1.0f;
+	};
+
 	void updateBand(const size_t index);
 
-	void updateBypassedStates();
+	/** Rebuilds the bands marked in mDirty and hands the result to the audio thread. Any thread. */
+	void publishAudioSnapshot();
+	void applyAudioSnapshot(const AudioSnapshot& snapshot);
+
+	void process(juce::AudioBuffer<float>& buffer, bool bypassed);
+	void processChunk(juce::dsp::AudioBlock<float> block);
+	void processFilter(FilterBand& filter, CrossfadeRamp& fade, juce::dsp::AudioBlock<float>& block);
+
+	void updatePlots(juce::uint32 changes);
 
-	void updatePlots();
+	void restoreParameters(const std::vector<float>& values);
+	void restoreSettings(const juce::NamedValueSet& settings);
+
+	/** Resizes the open editor to the saved size, message thread only. */
+	void handleAsyncUpdate() override;
 
 	juce::UndoManager mUndo;
 	juce::AudioProcessorValueTreeState mState;
@@ -167,19 +303,95 @@ private:
 	std::vector<Band> mBands;
 
 	std::vector<double> mFrequencies;
-	std::vector<double> mMagnitudes;
+	std::vector<double> mCompositeDB;
 
-	bool mWasBypassed = true;
-	
-	using FilterBand = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
-	using Gain = juce::dsp::Gain<float>;
-	juce::dsp::ProcessorChain<FilterBand, FilterBand, FilterBand, FilterBand, FilterBand, FilterBand, Gain> mFilter;
+	/** Everything a band's curve depends on, so an unchanged band is never re-evaluated. */
+	struct ResponseKey
+	{
+		FilterType type = LastFilterID;
+		float frequency = 0.0f;
+		float quality = 0.0f;
+		float gain = 0.0f;
+		double sampleRate = 0;
+
+		bool operator==(const ResponseKey& other) const
+		{
+			return type == other.type && frequency == other.frequency && quality == other.quality
+				&& gain == other.gain && sampleRate == other.sampleRate;
+		}
+		bool operator!=(const ResponseKey& other) const { return !operator==(other); }
+	};
 
-	double mSampleRate = 0;
+	struct BandResponse
+	{
+		ResponseEvaluator::Section section;
+		ResponseKey key;
+	};
+
+	using BandResponses = std::array<BandResponse, 6>;
+
+	ResponseEvaluator mResponse;
+	/** Written by publishAudioSnapshot() under mPublishLock, read by updateResponses() on the message thread. */
+	BandResponses mNextResponses;
+	TripleBuffer<BandResponses> mBandResponses;
+	std::vector<ResponseKey> mCachedKeys;
+	bool mCompositeValid = false;
+	juce::uint32 mCompositeBands = 0;
+	double mCompositeGainDB = 0;
+
+	ResponseOverlays mOverlays;
+	bool mShowPhase = false;
+	bool mShowGroupDelay = false;
+
+	std::array<std::atomic<juce::uint32>, 32> mGenerations{};
+	LoadMeter mLoadMeter;
+
+	struct ParameterValues
+	{
+		std::atomic<float>* type = nullptr;
+		std::atomic<float>* frequency = nullptr;
+		std::atomic<float>* quality = nullptr;
+		std::atomic<float>* gain = nullptr;
+		std::atomic<float>* active = nullptr;
+	};
 
-	int mSolo = -1;
+	std::vector<ParameterValues> mBandValues;
+	std::atomic<float>* mOutputValue = nullptr;
+	juce::HashMap<juce::String, int> mParameterBands;
+
+	/** In getStateParameterIDs() order. */
+	std::vector<juce::RangedAudioParameter*> mStateParameters;
+	std::vector<std::atomic<float>*> mStateValues;
+
+	/** Bit n marks band n for a rebuild; solo, listen and output changes only set switchesDirty. */
+	static constexpr juce::uint32 switchesDirty = 1u << 31;
+	std::atomic<juce::uint32> mDirty{ 0 };
+	std::atomic<bool> mBatchingUpdates{ false };
+	juce::SpinLock mPublishLock;
+	AudioSnapshot mNextSnapshot;
+	TripleBuffer<AudioSnapshot> mAudioSnapshot;
+
+	/** Only touched by the audio thread, apart from prepareToPlay(). */
+	std::array<FilterBand, 6> mBandFilters;
+	FilterBand mListenFilter;
+	Gain mOutputGain;
+	std::array<CrossfadeRamp, 6> mBandFades;
+	CrossfadeRamp mListenFade;
+	CrossfadeRamp mBypassFade;
+	std::atomic<double> mCrossfadeTime{ 0.01 };
+
+	/** One prepared block each: the band being faded, the input while the bypass fades, and the fade gains. */
+	juce::AudioBuffer<float> mWetBuffer;
+	juce::AudioBuffer<float> mDryBuffer;
+	std::vector<float> mFadeGains;
+
+	std::atomic<double> mSampleRate{ 0 };
+
+	std::atomic<int> mSolo{ -1 };
+	std::atomic<bool> mSoloListen{ false };
 
 	juce::Point<int> mEditorSize = { 1280, 800 };
+	mutable juce::SpinLock mEditorSizeLock;
 	
 	//==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Gainrev2AudioProcessor)
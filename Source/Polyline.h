@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    Polyline.h
+
+    Curves as the flattened points of their paths, the form CurveRenderer
+    draws. Whoever builds a path flattens it once, on its own thread, so
+    painting only copies the points over.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct Polyline
+{
+	using Points = std::vector<juce::Point<float>>;
+
+	/** Appends a flattened copy of the path's points to dest. */
+	static void appendPath(const juce::Path& path, Points& dest)
+	{
+		juce::PathFlatteningIterator it(path);
+		while (it.next())
+		{
+			if (dest.empty() || it.subPathIndex == 0)
+				dest.emplace_back(it.x1, it.y1);
+
+			// closing segments would only stroke along the plot's bottom edge
+			if (!it.closesSubPath)
+				dest.emplace_back(it.x2, it.y2);
+		}
+	}
+
+	/** Replaces dest with the path's points, reusing its storage. */
+	static void fromPath(const juce::Path& path, Points& dest)
+	{
+		dest.clear();
+		appendPath(path, dest);
+	}
+};
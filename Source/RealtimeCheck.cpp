@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+
+#if EQ_REALTIME_CHECKS
+
+#include <map>
+#include <mutex>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <time.h>
+ #include <unistd.h>
+
+ // the hooks run inside malloc, so TLS must not be allocated lazily
+ #define EQ_REALTIME_TLS __attribute__((tls_model("initial-exec")))
+#else
+ #define EQ_REALTIME_TLS
+#endif
+
+namespace
+{
+    // plain values only: a thread_local with a constructor could allocate inside the hooks
+    thread_local int tRealtimeDepth EQ_REALTIME_TLS = 0;
+    thread_local bool tRecording EQ_REALTIME_TLS = false;
+
+    std::mutex& getViolationLock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    std::map<juce::String, RealtimeCheck::Violation>& getViolationMap()
+    {
+        static std::map<juce::String, RealtimeCheck::Violation> violations;
+        return violations;
+    }
+}
+
+//==============================================================================
+RealtimeCheck::ScopedRealtime::ScopedRealtime()
+{
+    ++tRealtimeDepth;
+}
+
+RealtimeCheck::ScopedRealtime::~ScopedRealtime()
+{
+    --tRealtimeDepth;
+}
+
+void RealtimeCheck::violation(const char* what)
+{
+    if (tRealtimeDepth == 0 || tRecording)
+        return;
+
+    // everything below allocates and locks, which would land back in here,
+    // including the destructors, so the flag stays up until they have run
+    tRecording = true;
+    {
+        const auto stack = juce::SystemStats::getStackBacktrace();
+        const std::lock_guard<std::mutex> lock(getViolationLock());
+
+        auto& entry = getViolationMap()[juce::String(what) + "\n" + stack];
+        if (entry.count++ == 0)
+        {
+            entry.what = what;
+            entry.stack = stack;
+        }
+    }
+    tRecording = false;
+}
+
+std::vector<RealtimeCheck::Violation> RealtimeCheck::getViolations()
+{
+    std::vector<Violation> violations;
+    {
+        const std::lock_guard<std::mutex> lock(getViolationLock());
+        for (const auto& entry : getViolationMap())
+            violations.push_back(entry.second);
+    }
+
+    std::stable_sort(violations.begin(), violations.end(), [](const Violation& a, const Violation& b) { return a.count > b.count; });
+    return violations;
+}
+
+void RealtimeCheck::clearViolations()
+{
+    const std::lock_guard<std::mutex> lock(getViolationLock());
+    getViolationMap().clear();
+}
+
+//==============================================================================
+#if JUCE_LINUX
+
+// operator new ends up in malloc, so interposing the C allocator covers both
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t size) __THROW
+    {
+        RealtimeCheck::violation("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) __THROW
+    {
+        RealtimeCheck::violation("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) __THROW
+    {
+        RealtimeCheck::violation("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer) __THROW
+    {
+        if (pointer != nullptr)
+            RealtimeCheck::violation("free");
+
+        __libc_free(pointer);
+    }
+}
+
+namespace
+{
+    template <typename Function>
+    Function findNext(const char* name)
+    {
+        return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    }
+
+    // looked up once at startup, dlsym must not run for the first time on the audio thread
+    struct NextFunctions
+    {
+        decltype(&pthread_mutex_lock) mutexLock = findNext<decltype(&pthread_mutex_lock)>("pthread_mutex_lock");
+        decltype(&pthread_rwlock_rdlock) readLock = findNext<decltype(&pthread_rwlock_rdlock)>("pthread_rwlock_rdlock");
+        decltype(&pthread_rwlock_wrlock) writeLock = findNext<decltype(&pthread_rwlock_wrlock)>("pthread_rwlock_wrlock");
+        decltype(&pthread_cond_wait) conditionWait = findNext<decltype(&pthread_cond_wait)>("pthread_cond_wait");
+        decltype(&pthread_cond_timedwait) conditionTimedWait = findNext<decltype(&pthread_cond_timedwait)>("pthread_cond_timedwait");
+        decltype(&nanosleep) nanoSleep = findNext<decltype(&nanosleep)>("nanosleep");
+        decltype(&usleep) microSleep = findNext<decltype(&usleep)>("usleep");
+        decltype(&sched_yield) yield = findNext<decltype(&sched_yield)>("sched_yield");
+        decltype(&write) writeFile = findNext<decltype(&write)>("write");
+    };
+
+    const NextFunctions& next()
+    {
+        static const NextFunctions functions;
+        return functions;
+    }
+
+    struct HookInitialiser
+    {
+        HookInitialiser() { next(); }
+    } hookInitialiser;
+}
+
+extern "C"
+{
+    int pthread_mutex_lock(pthread_mutex_t* mutex) __THROWNL
+    {
+        RealtimeCheck::violation("pthread_mutex_lock");
+        return next().mutexLock(mutex);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock) __THROWNL
+    {
+        RealtimeCheck::violation("pthread_rwlock_rdlock");
+        return next().readLock(lock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock) __THROWNL
+    {
+        RealtimeCheck::violation("pthread_rwlock_wrlock");
+        return next().writeLock(lock);
+    }
+
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        RealtimeCheck::violation("pthread_cond_wait");
+        return next().conditionWait(condition, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        RealtimeCheck::violation("pthread_cond_timedwait");
+        return next().conditionTimedWait(condition, mutex, time);
+    }
+
+    int nanosleep(const struct timespec* requested, struct timespec* remaining)
+    {
+        RealtimeCheck::violation("nanosleep");
+        return next().nanoSleep(requested, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        RealtimeCheck::violation("usleep");
+        return next().microSleep(microseconds);
+    }
+
+    int sched_yield() __THROW
+    {
+        RealtimeCheck::violation("sched_yield");
+        return next().yield();
+    }
+
+    ssize_t write(int file, const void* data, size_t size)
+    {
+        RealtimeCheck::violation("write");
+        return next().writeFile(file, data, size);
+    }
+}
+
+//==============================================================================
+#else
+
+// elsewhere only the C++ allocator can be replaced portably
+void* operator new(std::size_t size)
+{
+    RealtimeCheck::violation("operator new");
+
+    if (auto* pointer = std::malloc(size > 0 ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeCheck::violation("operator new");
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeCheck::violation("operator delete");
+
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+#endif // JUCE_LINUX
+
+#endif // EQ_REALTIME_CHECKS
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+
+    Debug instrumentation for the audio callback. Code inside a ScopedRealtime
+    (processBlock, and whatever a test host runs on its audio thread) is
+    watched for heap allocations, lock acquisitions and blocking system
+    calls; each one is recorded with the stack it came from.
+
+    Only compiled in when EQ_REALTIME_CHECKS is set to 1. Allocations are
+    caught everywhere by replacing operator new and delete; on Linux malloc,
+    pthread locks and waits, sleeps, yields and writes are interposed instead.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef EQ_REALTIME_CHECKS
+ #define EQ_REALTIME_CHECKS 0
+#endif
+
+class RealtimeCheck
+{
+public:
+	//==============================================================================
+	static constexpr bool enabled = EQ_REALTIME_CHECKS != 0;
+
+	struct Violation
+	{
+		juce::String what;
+		juce::String stack;
+		int count = 0;
+	};
+
+	/** Marks the calling thread as real-time for as long as it exists. Nests. */
+	class ScopedRealtime
+	{
+	public:
+#if EQ_REALTIME_CHECKS
+		ScopedRealtime();
+		~ScopedRealtime();
+#else
+		ScopedRealtime() = default;
+#endif
+
+		JUCE_DECLARE_NON_COPYABLE(ScopedRealtime)
+	};
+
+#if EQ_REALTIME_CHECKS
+	/** Records what happened if the calling thread is inside a ScopedRealtime. */
+	static void violation(const char* what);
+
+	/** Every distinct violation so far, the most frequent first. */
+	static std::vector<Violation> getViolations();
+	static void clearViolations();
+#else
+	static void violation(const char*) {}
+	static std::vector<Violation> getViolations() { return {}; }
+	static void clearViolations() {}
+#endif
+
+private:
+	//==============================================================================
+	RealtimeCheck() = delete;
+};
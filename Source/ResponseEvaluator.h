@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+    ResponseEvaluator.h
+
+    Evaluates the magnitude response of a set of first and second order
+    sections over a fixed frequency grid. The cos/sin terms of every grid
+    point are tabulated once per grid, so a band evaluation is multiply-adds
+    over contiguous arrays and one log10 per point. Curves are kept in dB, so
+    the composite is a running sum that a single band change updates with one
+    vector subtract and one vector add. Phase and group delay come from the
+    same tables.
+
+    The per-point loops stay scalar on purpose: the log10 (or atan2) costs
+    about two thirds of a point, and moving the multiply-adds into
+    FloatVectorOperations over temporary blocks made a point slower, not
+    faster.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class ResponseEvaluator
+{
+public:
+	//==============================================================================
+	/** Grid points are processed in blocks of this size, so the tables and the
+		composite stay in cache while every band passes over them.
+	*/
+	static constexpr int blockSize = 64;
+
+	/** Zeros of notches and an output gain of 0 are clamped here instead of -inf,
+		so the running sum can always subtract a curve out again.
+	*/
+	static constexpr double floorDB = -200.0;
+
+	/** Normalised coefficients, a0 == 1. First order sections leave b2 and a2 at 0. */
+	struct Section
+	{
+		double b0 = 1.0, b1 = 0.0, b2 = 0.0;
+		double a1 = 0.0, a2 = 0.0;
+
+		static Section fromCoefficients(const juce::dsp::IIR::Coefficients<float>& coefficients)
+		{
+			const auto* c = coefficients.getRawCoefficients();
+			Section section;
+
+			if (coefficients.getFilterOrder() == 1)
+			{
+				section.b0 = c[0];
+				section.b1 = c[1];
+				section.a1 = c[2];
+			}
+			else if (coefficients.getFilterOrder() == 2)
+			{
+				section.b0 = c[0];
+				section.b1 = c[1];
+				section.b2 = c[2];
+				section.a1 = c[3];
+				section.a2 = c[4];
+			}
+			return section;
+		}
+
+		/** From b0, b1, b2, a1, a2 as BiquadDesign returns them. */
+		static Section fromBiquad(const float* c)
+		{
+			Section section;
+			section.b0 = c[0];
+			section.b1 = c[1];
+			section.b2 = c[2];
+			section.a1 = c[3];
+			section.a2 = c[4];
+			return section;
+		}
+
+		bool operator==(const Section& other) const
+		{
+			return b0 == other.b0 && b1 == other.b1 && b2 == other.b2 && a1 == other.a1 && a2 == other.a2;
+		}
+	};
+
+	void prepare(const std::vector<double>& frequencies, double sampleRateToUse)
+	{
+		mSampleRate = sampleRateToUse;
+
+		const auto numPoints = frequencies.size();
+		mCos1.resize(numPoints);
+		mSin1.resize(numPoints);
+		mCos2.resize(numPoints);
+		mSin2.resize(numPoints);
+
+		for (size_t i = 0; i < numPoints; ++i)
+		{
+			const auto w = juce::MathConstants<double>::twoPi * frequencies[i] / mSampleRate;
+			mCos1[i] = std::cos(w);
+			mSin1[i] = std::sin(w);
+			mCos2[i] = std::cos(2.0 * w);
+			mSin2[i] = std::sin(2.0 * w);
+		}
+	}
+
+	int getNumPoints() const { return int(mCos1.size()); }
+	double getSampleRate() const { return mSampleRate; }
+
+	/** Updates the dB composite in one pass over the grid. For every section,
+		its old curve is subtracted if flagged in removeMask, it is re-evaluated
+		if flagged in evaluateMask, and the new curve is added if flagged in
+		addMask. gainDeltaDB is added to every point for output gain changes.
+	*/
+	void process(const Section* sections, double* const* curves, int numSections,
+		juce::uint32 evaluateMask, juce::uint32 removeMask, juce::uint32 addMask,
+		double gainDeltaDB, double* composite) const
+	{
+		const auto numPoints = getNumPoints();
+
+		for (int start = 0; start < numPoints; start += blockSize)
+		{
+			const auto num = juce::jmin(blockSize, numPoints - start);
+			auto* sum = composite + start;
+
+			if (gainDeltaDB != 0.0)
+				juce::FloatVectorOperations::add(sum, gainDeltaDB, num);
+
+			for (int s = 0; s < numSections; ++s)
+			{
+				const auto bit = juce::uint32(1) << s;
+				auto* curve = curves[s] + start;
+
+				if ((removeMask & bit) != 0)
+					juce::FloatVectorOperations::subtract(sum, curve, num);
+
+				if ((evaluateMask & bit) != 0)
+					evaluateBlock(sections[s], start, num, curve);
+
+				if ((addMask & bit) != 0)
+					juce::FloatVectorOperations::add(sum, curve, num);
+			}
+		}
+	}
+
+	/** Writes phase in radians and group delay in samples for every section
+		flagged in evaluateMask, then rebuilds the composite phase and delay from
+		the sections flagged in combineMask. The composite phase is wrapped back
+		to [-pi, pi] after summing.
+	*/
+	void processPhase(const Section* sections, double* const* phases, double* const* delays, int numSections,
+		juce::uint32 evaluateMask, juce::uint32 combineMask, double* compositePhase, double* compositeDelay) const
+	{
+		const auto numPoints = getNumPoints();
+
+		for (int start = 0; start < numPoints; start += blockSize)
+		{
+			const auto num = juce::jmin(blockSize, numPoints - start);
+			auto* phaseSum = compositePhase + start;
+			auto* delaySum = compositeDelay + start;
+
+			juce::FloatVectorOperations::clear(phaseSum, num);
+			juce::FloatVectorOperations::clear(delaySum, num);
+
+			for (int s = 0; s < numSections; ++s)
+			{
+				const auto bit = juce::uint32(1) << s;
+				auto* phase = phases[s] + start;
+				auto* delay = delays[s] + start;
+
+				if ((evaluateMask & bit) != 0)
+					evaluatePhaseBlock(sections[s], start, num, phase, delay);
+
+				if ((combineMask & bit) != 0)
+				{
+					juce::FloatVectorOperations::add(phaseSum, phase, num);
+					juce::FloatVectorOperations::add(delaySum, delay, num);
+				}
+			}
+
+			for (int i = 0; i < num; ++i)
+				phaseSum[i] = std::remainder(phaseSum[i], juce::MathConstants<double>::twoPi);
+		}
+	}
+
+private:
+	//==============================================================================
+	void evaluatePhaseBlock(const Section& section, int start, int num, double* phase, double* delay) const
+	{
+		const auto* c1 = mCos1.data() + start;
+		const auto* s1 = mSin1.data() + start;
+		const auto* c2 = mCos2.data() + start;
+		const auto* s2 = mSin2.data() + start;
+
+		for (int i = 0; i < num; ++i)
+		{
+			const auto numRe = section.b0 + section.b1 * c1[i] + section.b2 * c2[i];
+			const auto numIm = -(section.b1 * s1[i] + section.b2 * s2[i]);
+			const auto denRe = 1.0 + section.a1 * c1[i] + section.a2 * c2[i];
+			const auto denIm = -(section.a1 * s1[i] + section.a2 * s2[i]);
+
+			phase[i] = std::remainder(std::atan2(numIm, numRe) - std::atan2(denIm, denRe), juce::MathConstants<double>::twoPi);
+
+			// the group delay of P = sum p_k e^-jwk is Re(Q / P) with Q = sum k p_k e^-jwk
+			const auto numKRe = section.b1 * c1[i] + 2.0 * section.b2 * c2[i];
+			const auto numKIm = -(section.b1 * s1[i] + 2.0 * section.b2 * s2[i]);
+			const auto denKRe = section.a1 * c1[i] + 2.0 * section.a2 * c2[i];
+			const auto denKIm = -(section.a1 * s1[i] + 2.0 * section.a2 * s2[i]);
+
+			const auto numPower = numRe * numRe + numIm * numIm;
+			const auto denPower = denRe * denRe + denIm * denIm;
+			const auto numDelay = numPower > 1.0e-30 ? (numKRe * numRe + numKIm * numIm) / numPower : 0.0;
+
+			delay[i] = numDelay - (denKRe * denRe + denKIm * denIm) / denPower;
+		}
+	}
+
+	void evaluateBlock(const Section& section, int start, int num, double* dest) const
+	{
+		const auto* c1 = mCos1.data() + start;
+		const auto* s1 = mSin1.data() + start;
+		const auto* c2 = mCos2.data() + start;
+		const auto* s2 = mSin2.data() + start;
+
+		// 20 log10 |b0 + b1 z^-1 + b2 z^-2| / |1 + a1 z^-1 + a2 z^-2| with z = e^jw,
+		// taken as 10 log10 of the squared ratio so no square root is needed
+		const auto floorPower = std::pow(10.0, floorDB / 10.0);
+
+		for (int i = 0; i < num; ++i)
+		{
+			const auto numRe = section.b0 + section.b1 * c1[i] + section.b2 * c2[i];
+			const auto numIm = section.b1 * s1[i] + section.b2 * s2[i];
+			const auto denRe = 1.0 + section.a1 * c1[i] + section.a2 * c2[i];
+			const auto denIm = section.a1 * s1[i] + section.a2 * s2[i];
+
+			const auto power = (numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm);
+			dest[i] = 10.0 * std::log10(juce::jmax(power, floorPower));
+		}
+	}
+
+	//==============================================================================
+	std::vector<double> mCos1, mSin1, mCos2, mSin2;
+	double mSampleRate = 0;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResponseEvaluator)
+};
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    ResponseOverlays.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseOverlays.h"
+
+ResponseOverlays::ResponseOverlays() : juce::Thread("Response Overlays")
+{
+}
+
+ResponseOverlays::~ResponseOverlays()
+{
+    stopThread(1000);
+}
+
+void ResponseOverlays::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled == mEnabled)
+        return;
+
+    mEnabled = shouldBeEnabled;
+
+    if (mEnabled)
+    {
+        startThread(3);
+    }
+    else
+    {
+        stopThread(1000);
+
+        // the next request after re-enabling has to go through even if it is identical
+        mLastRequest = Request();
+        const juce::ScopedLock requestLock(mRequestLock);
+        mHasPending = false;
+    }
+}
+
+bool ResponseOverlays::isEnabled() const
+{
+    return mEnabled;
+}
+
+void ResponseOverlays::request(const std::vector<double>& frequencies, double sampleRate,
+    const std::vector<ResponseEvaluator::Section>& sections, juce::uint32 combineMask)
+{
+    if (!mEnabled)
+        return;
+
+    Request newRequest{ frequencies, sampleRate, sections, combineMask };
+    if (newRequest == mLastRequest)
+        return;
+
+    mLastRequest = newRequest;
+    {
+        const juce::ScopedLock requestLock(mRequestLock);
+        mPending = std::move(newRequest);
+        mHasPending = true;
+    }
+    notify();
+}
+
+bool ResponseOverlays::getCurves(Curves& dest)
+{
+    const juce::ScopedLock resultLock(mResultLock);
+    if (!mResultReady)
+        return false;
+
+    std::swap(dest, mResult);
+    mResultReady = false;
+    return true;
+}
+
+void ResponseOverlays::run()
+{
+    while (!threadShouldExit())
+    {
+        Request next;
+        {
+            const juce::ScopedLock requestLock(mRequestLock);
+            if (mHasPending)
+            {
+                std::swap(next, mPending);
+                mHasPending = false;
+            }
+        }
+
+        if (next.sampleRate > 0 && !next.frequencies.empty())
+            calculate(next);
+        else
+            wait(-1);
+    }
+}
+
+void ResponseOverlays::calculate(const Request& request)
+{
+    const auto numPoints = request.frequencies.size();
+    const auto numBands = request.sections.size();
+
+    if (mEvaluator.getSampleRate() != request.sampleRate || mEvaluator.getNumPoints() != int(numPoints)
+        || mRaw.bandPhase.size() != numBands)
+    {
+        mEvaluator.prepare(request.frequencies, request.sampleRate);
+        mCachedSections.clear();
+
+        mRaw.bandPhase.assign(numBands, std::vector<double>(numPoints, 0.0));
+        mRaw.bandDelay.assign(numBands, std::vector<double>(numPoints, 0.0));
+        mRaw.phase.assign(numPoints, 0.0);
+        mRaw.delay.assign(numPoints, 0.0);
+    }
+
+    juce::uint32 evaluateMask = 0;
+    std::vector<double*> phases, delays;
+    for (size_t i = 0; i < numBands; ++i)
+    {
+        if (i >= mCachedSections.size() || !(mCachedSections[i] == request.sections[i]))
+            evaluateMask |= juce::uint32(1) << i;
+
+        phases.push_back(mRaw.bandPhase[i].data());
+        delays.push_back(mRaw.bandDelay[i].data());
+    }
+    mCachedSections = request.sections;
+
+    mEvaluator.processPhase(request.sections.data(), phases.data(), delays.data(), int(numBands),
+        evaluateMask, request.combineMask, mRaw.phase.data(), mRaw.delay.data());
+
+    // the raw curves stay in radians and samples so they can be reused next time
+    auto result = mRaw;
+    const auto toDegrees = 180.0 / juce::MathConstants<double>::pi;
+    const auto toMilliseconds = 1000.0 / request.sampleRate;
+
+    for (auto& curve : result.bandPhase)
+        juce::FloatVectorOperations::multiply(curve.data(), toDegrees, int(curve.size()));
+    for (auto& curve : result.bandDelay)
+        juce::FloatVectorOperations::multiply(curve.data(), toMilliseconds, int(curve.size()));
+    juce::FloatVectorOperations::multiply(result.phase.data(), toDegrees, int(numPoints));
+    juce::FloatVectorOperations::multiply(result.delay.data(), toMilliseconds, int(numPoints));
+
+    {
+        const juce::ScopedLock resultLock(mResultLock);
+        std::swap(mResult, result);
+        mResultReady = true;
+    }
+
+    if (onCurvesReady)
+        onCurvesReady();
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    ResponseOverlays.h
+
+    Background worker for the phase and group delay overlays. The message
+    thread hands it the current band sections; it re-evaluates only the bands
+    whose coefficients changed and publishes finished curves for the editor
+    to pick up, so the overlays never cost the paint call anything but a
+    stroke.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ResponseEvaluator.h"
+
+class ResponseOverlays : private juce::Thread
+{
+public:
+	//==============================================================================
+	/** Phase in degrees and group delay in milliseconds, one value per grid point. */
+	struct Curves
+	{
+		std::vector<std::vector<double>> bandPhase;
+		std::vector<std::vector<double>> bandDelay;
+		std::vector<double> phase;
+		std::vector<double> delay;
+	};
+
+	ResponseOverlays();
+	~ResponseOverlays() override;
+
+	/** Starts or stops the worker. Nothing is computed while it is disabled. */
+	void setEnabled(bool shouldBeEnabled);
+	bool isEnabled() const;
+
+	/** Queues a recalculation, unless nothing changed since the last request. */
+	void request(const std::vector<double>& frequencies, double sampleRate,
+		const std::vector<ResponseEvaluator::Section>& sections, juce::uint32 combineMask);
+
+	/** Copies the latest curves into dest. Returns false if nothing new arrived
+		since the last call, in which case dest is left untouched.
+	*/
+	bool getCurves(Curves& dest);
+
+	/** Called on the worker thread whenever a new set of curves is ready. */
+	std::function<void()> onCurvesReady;
+
+private:
+	//==============================================================================
+	struct Request
+	{
+		std::vector<double> frequencies;
+		double sampleRate = 0;
+		std::vector<ResponseEvaluator::Section> sections;
+		juce::uint32 combineMask = 0;
+
+		bool operator==(const Request& other) const
+		{
+			return sampleRate == other.sampleRate && combineMask == other.combineMask
+				&& frequencies == other.frequencies && sections == other.sections;
+		}
+	};
+
+	void run() override;
+	void calculate(const Request& request);
+
+	//==============================================================================
+	bool mEnabled = false;
+	Request mLastRequest;
+
+	juce::CriticalSection mRequestLock;
+	Request mPending;
+	bool mHasPending = false;
+
+	// owned by the worker thread
+	ResponseEvaluator mEvaluator;
+	std::vector<ResponseEvaluator::Section> mCachedSections;
+	Curves mRaw;
+
+	juce::CriticalSection mResultLock;
+	Curves mResult;
+	bool mResultReady = false;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResponseOverlays)
+};
@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    SpectrogramRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrogramRenderer.h"
+
+#ifdef JUCE_OPENGL
+
+#if JUCE_VERSION >= 0x60100
+using namespace juce::gl;
+#endif
+
+// GLSL 1.10 / ES 2.0 with RGBA8 textures and no VAOs, so Mesa's software
+// rasteriser on a headless box runs exactly the same path as a desktop GPU.
+static const char* spectrogramVertexShader =
+    "attribute vec2 position;\n"
+    "varying vec2 texCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    texCoord = position * 0.5 + 0.5;\n"
+    "    gl_Position = vec4(position, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* spectrogramFragmentShader =
+    "varying " JUCE_MEDIUMP " vec2 texCoord;\n"
+    "uniform sampler2D history;\n"
+    "uniform " JUCE_MEDIUMP " float newestRow;\n"
+    "uniform " JUCE_MEDIUMP " float rowSpan;\n"
+    "void main()\n"
+    "{\n"
+    "    " JUCE_MEDIUMP " float level = texture2D(history, vec2(texCoord.x, newestRow - (1.0 - texCoord.y) * rowSpan)).r;\n"
+    "    " JUCE_MEDIUMP " vec3 colour = vec3(smoothstep(0.35, 0.75, level),\n"
+    "                                       smoothstep(0.6, 1.0, level),\n"
+    "                                       smoothstep(0.0, 0.35, level) - 0.8 * smoothstep(0.55, 0.8, level));\n"
+    "    gl_FragColor = vec4(colour, smoothstep(0.05, 0.3, level));\n"
+    "}\n";
+
+SpectrogramRenderer::SpectrogramRenderer(int rowWidth) : mRowWidth(rowWidth)
+{
+    mRowPixels.resize(size_t(mRowWidth) * 4);
+}
+
+SpectrogramRenderer::~SpectrogramRenderer()
+{
+    // release() has to run on the GL thread before the context goes away
+    jassert(mTexture == 0 && mShader == nullptr);
+}
+
+void SpectrogramRenderer::create(juce::OpenGLContext& context)
+{
+    mShader = std::make_unique<juce::OpenGLShaderProgram>(context);
+
+    if (!mShader->addVertexShader(juce::OpenGLHelpers::translateVertexShaderToV3(spectrogramVertexShader))
+        || !mShader->addFragmentShader(juce::OpenGLHelpers::translateFragmentShaderToV3(spectrogramFragmentShader))
+        || !mShader->link())
+    {
+        DBG("Spectrogram shader failed: " << mShader->getLastError());
+        mShader.reset();
+        return;
+    }
+
+    mNewestRow = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*mShader, "newestRow");
+    mRowSpan = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*mShader, "rowSpan");
+    mHistory = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*mShader, "history");
+    mPosition = std::make_unique<juce::OpenGLShaderProgram::Attribute>(*mShader, "position");
+
+    std::vector<juce::uint8> blank(size_t(mRowWidth) * numHistoryRows * 4, 0);
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mRowWidth, numHistoryRows, 0, GL_RGBA, GL_UNSIGNED_BYTE, blank.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    const GLfloat quad[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+    context.extensions.glGenBuffers(1, &mVertexBuffer);
+    context.extensions.glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    context.extensions.glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    context.extensions.glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    mWriteRow = 0;
+}
+
+void SpectrogramRenderer::release(juce::OpenGLContext& context)
+{
+    if (mTexture != 0)
+    {
+        glDeleteTextures(1, &mTexture);
+        mTexture = 0;
+    }
+    if (mVertexBuffer != 0)
+    {
+        context.extensions.glDeleteBuffers(1, &mVertexBuffer);
+        mVertexBuffer = 0;
+    }
+
+    mPosition.reset();
+    mHistory.reset();
+    mRowSpan.reset();
+    mNewestRow.reset();
+    mShader.reset();
+}
+
+void SpectrogramRenderer::uploadRows(const juce::uint8* rows, int numRows)
+{
+    if (mTexture == 0 || numRows <= 0)
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        const auto* source = rows + row * mRowWidth;
+        for (int i = 0; i < mRowWidth; ++i)
+        {
+            auto* pixel = mRowPixels.data() + i * 4;
+            pixel[0] = pixel[1] = pixel[2] = source[i];
+            pixel[3] = 255;
+        }
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, mWriteRow, mRowWidth, 1, GL_RGBA, GL_UNSIGNED_BYTE, mRowPixels.data());
+        mWriteRow = (mWriteRow + 1) % numHistoryRows;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SpectrogramRenderer::render(juce::OpenGLContext& context, juce::Rectangle<int> viewport)
+{
+    if (mShader == nullptr || mTexture == 0 || viewport.isEmpty())
+        return;
+
+    glViewport(viewport.getX(), viewport.getY(), viewport.getWidth(), viewport.getHeight());
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    mShader->use();
+
+    context.extensions.glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    mHistory->set(0);
+
+    const auto newest = (float(mWriteRow) - 0.5f) / numHistoryRows;
+    mNewestRow->set(newest);
+    mRowSpan->set(float(numHistoryRows - 1) / numHistoryRows);
+
+    context.extensions.glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    context.extensions.glVertexAttribPointer(GLuint(mPosition->attributeID), 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    context.extensions.glEnableVertexAttribArray(GLuint(mPosition->attributeID));
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    context.extensions.glDisableVertexAttribArray(GLuint(mPosition->attributeID));
+    context.extensions.glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+#endif // JUCE_OPENGL
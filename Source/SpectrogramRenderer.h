@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    SpectrogramRenderer.h
+
+    Scrolling spectrogram drawn with OpenGL. Every analyser frame becomes one
+    row of a ring-buffer texture, so keeping the whole history on screen costs
+    a single row upload per frame plus one textured quad.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifdef JUCE_OPENGL
+
+class SpectrogramRenderer
+{
+public:
+	//==============================================================================
+	static constexpr int numHistoryRows = 256;
+
+	SpectrogramRenderer(int rowWidth);
+	~SpectrogramRenderer();
+
+	/** Must be called on the GL thread, from newOpenGLContextCreated(). */
+	void create(juce::OpenGLContext& context);
+
+	/** Must be called on the GL thread, from openGLContextClosing(). */
+	void release(juce::OpenGLContext& context);
+
+	/** Copies single-byte magnitude rows into the ring texture, oldest first. */
+	void uploadRows(const juce::uint8* rows, int numRows);
+
+	/** Draws the history into the given viewport, in physical GL pixels. */
+	void render(juce::OpenGLContext& context, juce::Rectangle<int> viewport);
+
+private:
+	//==============================================================================
+	const int mRowWidth;
+
+	std::unique_ptr<juce::OpenGLShaderProgram> mShader;
+	std::unique_ptr<juce::OpenGLShaderProgram::Uniform> mNewestRow;
+	std::unique_ptr<juce::OpenGLShaderProgram::Uniform> mRowSpan;
+	std::unique_ptr<juce::OpenGLShaderProgram::Uniform> mHistory;
+	std::unique_ptr<juce::OpenGLShaderProgram::Attribute> mPosition;
+
+	GLuint mTexture = 0;
+	GLuint mVertexBuffer = 0;
+	int mWriteRow = 0;
+
+	std::vector<juce::uint8> mRowPixels;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramRenderer)
+};
+
+#endif // JUCE_OPENGL
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    StateFormat.cpp
+
+  ==============================================================================
+*/
+
+#include "StateFormat.h"
+
+namespace
+{
+    // four characters each, read as little endian ints
+    constexpr int magic = 0x74735145;         // "EQst"
+    constexpr int parametersTag = 0x4d524150; // "PARM"
+    constexpr int settingsTag = 0x54544553;   // "SETT"
+
+    void writeChunk(juce::OutputStream& stream, int tag, const juce::MemoryOutputStream& chunk)
+    {
+        stream.writeInt(tag);
+        stream.writeInt(int(chunk.getDataSize()));
+        stream.write(chunk.getData(), chunk.getDataSize());
+    }
+}
+
+void StateFormat::write(const Contents& contents, juce::MemoryBlock& dest)
+{
+    juce::MemoryOutputStream stream(dest, false);
+    stream.writeInt(magic);
+    stream.writeInt(currentVersion);
+
+    juce::MemoryOutputStream parameters;
+    parameters.writeInt(int(contents.parameters.size()));
+    for (const auto value : contents.parameters)
+        parameters.writeFloat(value);
+    writeChunk(stream, parametersTag, parameters);
+
+    juce::MemoryOutputStream settings;
+    settings.writeInt(contents.settings.size());
+    for (const auto& setting : contents.settings)
+    {
+        settings.writeString(setting.name.toString());
+        setting.value.writeToStream(settings);
+    }
+    writeChunk(stream, settingsTag, settings);
+}
+
+bool StateFormat::read(const void* data, size_t sizeInBytes, Contents& contents)
+{
+    if (!isBinaryState(data, sizeInBytes))
+        return false;
+
+    juce::MemoryInputStream stream(data, sizeInBytes, false);
+    stream.readInt();
+    contents.version = stream.readInt();
+    contents.parameters.clear();
+    contents.settings.clear();
+    auto hasParameters = false;
+
+    while (stream.getNumBytesRemaining() >= 8)
+    {
+        const auto tag = stream.readInt();
+        const auto chunkSize = stream.readInt();
+        if (chunkSize < 0 || chunkSize > stream.getNumBytesRemaining())
+            return false;
+
+        juce::MemoryInputStream chunk(static_cast<const char*>(data) + stream.getPosition(), size_t(chunkSize), false);
+        stream.skipNextBytes(chunkSize);
+
+        if (tag == parametersTag)
+        {
+            const auto count = chunk.readInt();
+            if (count < 0 || count > chunk.getNumBytesRemaining() / 4)
+                return false;
+
+            contents.parameters.resize(size_t(count));
+            for (auto& value : contents.parameters)
+                value = chunk.readFloat();
+            hasParameters = true;
+        }
+        else if (tag == settingsTag)
+        {
+            const auto count = chunk.readInt();
+            for (int i = 0; i < count && !chunk.isExhausted(); ++i)
+            {
+                const auto name = chunk.readString();
+                auto value = juce::var::readFromStream(chunk);
+                if (name.isNotEmpty())
+                    contents.settings.set(name, std::move(value));
+            }
+        }
+        // anything else was written by a newer build
+    }
+
+    // every version writes its parameters, a state without them is damaged
+    if (!hasParameters)
+        return false;
+
+    return migrate(contents);
+}
+
+bool StateFormat::migrate(Contents& contents)
+{
+    if (contents.version < 1)
+        return false;
+
+    if (int(contents.parameters.size()) < getNumParameters(juce::jmin(contents.version, currentVersion)))
+        return false;
+
+    if (contents.version > currentVersion)
+    {
+        contents.parameters.resize(size_t(getNumParameters(currentVersion)));
+        contents.version = currentVersion;
+        return true;
+    }
+
+    // version 1 is current; each later version adds one step here that turns
+    // version - 1 contents into its own, e.g. renaming a setting or converting
+    // a parameter's range; parameters it added are left to the caller's defaults
+
+    return contents.version == currentVersion;
+}
+
+int StateFormat::getNumParameters(int version)
+{
+    // output, then type, frequency, quality, gain and active for six bands
+    switch (version)
+    {
+        case 1:  return 1 + 6 * 5;
+        default: jassertfalse; return 0;
+    }
+}
+
+bool StateFormat::isBinaryState(const void* data, size_t sizeInBytes)
+{
+    return data != nullptr && sizeInBytes >= 8
+        && juce::ByteOrder::littleEndianInt(data) == juce::uint32(magic);
+}
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    StateFormat.h
+
+    The binary layout getStateInformation() writes: the magic "EQst", an
+    int32 schema version, then chunks of int32 tag, int32 size and payload,
+    all little endian. The parameter chunk holds the plain values in the
+    order of Gainrev2AudioProcessor::getStateParameterIDs(), the settings
+    chunk holds named values for everything that isn't a parameter.
+
+    Readers skip chunks they don't know, and a new schema version may only
+    append parameters to the list, so an older build reads what it knows of
+    a newer state and a newer build fills in defaults for an older one.
+    Anything else a new version changes goes into migrate().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct StateFormat
+{
+	/** 0 is the ValueTree written before this format existed. */
+	static constexpr int currentVersion = 1;
+
+	struct Contents
+	{
+		int version = currentVersion;
+		std::vector<float> parameters;
+		juce::NamedValueSet settings;
+	};
+
+	static void write(const Contents& contents, juce::MemoryBlock& dest);
+
+	/** Returns false if the data isn't in this format, is damaged or has no
+		parameters. On success contents are migrated to currentVersion.
+	*/
+	static bool read(const void* data, size_t sizeInBytes, Contents& contents);
+
+	/** Brings contents written by any binary version to currentVersion. A newer
+		version keeps only the parameters this one knows, which the append-only
+		rule guarantees still mean the same. Returns false for versions that
+		never existed or parameter lists shorter than their version wrote.
+	*/
+	static bool migrate(Contents& contents);
+
+	/** How many parameters the given version writes. */
+	static int getNumParameters(int version);
+
+	static bool isBinaryState(const void* data, size_t sizeInBytes);
+};
@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+
+    TraceEvents.cpp
+
+  ==============================================================================
+*/
+
+#include "TraceEvents.h"
+
+#if EQ_TRACE_EVENTS
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    constexpr int numRings = 16;
+    constexpr juce::uint64 ringSize = 4096;
+
+    struct Event
+    {
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<juce::int64> ticks{ 0 };
+        std::atomic<char> phase{ 0 };
+    };
+
+    /** Written by one thread only; the reader copies and then checks it wasn't lapped. */
+    struct Ring
+    {
+        std::array<Event, ringSize> events;
+        std::atomic<juce::uint64> written{ 0 };
+        std::atomic<juce::uint64> clearedAt{ 0 };
+        std::atomic<bool> owned{ false };
+
+        std::atomic<bool> nameBusy{ false };
+        char threadName[64] = {};
+    };
+
+    struct ScopedNameLock
+    {
+        explicit ScopedNameLock(Ring& ringToLock) : ring(ringToLock)
+        {
+            while (ring.nameBusy.exchange(true, std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+
+        ~ScopedNameLock()
+        {
+            ring.nameBusy.store(false, std::memory_order_release);
+        }
+
+        Ring& ring;
+    };
+
+    using Rings = std::array<Ring, numRings>;
+
+    /** Allocated by prepare(), so builds that never record don't pay for the rings. */
+    struct Pool
+    {
+        ~Pool()
+        {
+            delete rings.exchange(nullptr);
+        }
+
+        std::atomic<Rings*> rings{ nullptr };
+        std::once_flag allocated;
+    };
+
+    Pool pool;
+
+    // plain values, so the slots need neither a constructor nor an exit handler on first use
+    thread_local Ring* tRing = nullptr;
+    thread_local bool tExhausted = false;
+
+    void setThreadName(Ring& ring, int index)
+    {
+        const ScopedNameLock nameLock(ring);
+
+        // no juce::String temporaries, this can run on the audio thread
+        if (auto* thread = juce::Thread::getCurrentThread())
+            thread->getThreadName().copyToUTF8(ring.threadName, sizeof(ring.threadName));
+        else if (juce::MessageManager::existsAndIsCurrentThread())
+            std::strcpy(ring.threadName, "Message thread");
+        else
+            std::snprintf(ring.threadName, sizeof(ring.threadName), "Thread %d", index + 1);
+    }
+
+    Ring* getThreadRing()
+    {
+        if (tRing != nullptr || tExhausted)
+            return tRing;
+
+        auto* rings = pool.rings.load(std::memory_order_acquire);
+        if (rings == nullptr)
+            return nullptr;
+
+        // unused rings first, so exited threads stay in the trace for as long as possible
+        for (const auto reuse : { false, true })
+        {
+            for (int i = 0; i < numRings; ++i)
+            {
+                auto& ring = (*rings)[size_t(i)];
+                if (!reuse && ring.written.load(std::memory_order_relaxed) != 0)
+                    continue;
+
+                bool expected = false;
+                if (ring.owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                {
+                    // whatever an exited owner left behind would show up under the new name
+                    ring.clearedAt.store(ring.written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    setThreadName(ring, i);
+                    return tRing = &ring;
+                }
+            }
+        }
+
+        tExhausted = true;
+        return nullptr;
+    }
+
+    void record(const char* name, char phase)
+    {
+        auto* ring = getThreadRing();
+        if (ring == nullptr)
+            return;
+
+        const auto index = ring->written.load(std::memory_order_relaxed);
+        auto& event = ring->events[size_t(index % ringSize)];
+        event.name.store(name, std::memory_order_relaxed);
+        event.ticks.store(juce::Time::getHighResolutionTicks(), std::memory_order_relaxed);
+        event.phase.store(phase, std::memory_order_relaxed);
+        ring->written.store(index + 1, std::memory_order_release);
+    }
+
+    struct CopiedEvent
+    {
+        const char* name;
+        juce::int64 ticks;
+        char phase;
+    };
+
+    std::vector<CopiedEvent> copyEvents(Ring& ring)
+    {
+        const auto written = ring.written.load(std::memory_order_acquire);
+        const auto first = juce::jmax(ring.clearedAt.load(std::memory_order_relaxed), written > ringSize ? written - ringSize : 0);
+
+        std::vector<CopiedEvent> events;
+        events.reserve(size_t(written - first));
+        for (auto i = first; i < written; ++i)
+        {
+            const auto& event = ring.events[size_t(i % ringSize)];
+            events.push_back({ event.name.load(std::memory_order_relaxed),
+                               event.ticks.load(std::memory_order_relaxed),
+                               event.phase.load(std::memory_order_relaxed) });
+        }
+
+        // drop whatever the writer overwrote while we were copying
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto writtenAfter = ring.written.load(std::memory_order_relaxed);
+        if (writtenAfter >= ringSize && writtenAfter - ringSize + 1 > first)
+            events.erase(events.begin(), events.begin() + std::ptrdiff_t(juce::jmin(written, writtenAfter - ringSize + 1) - first));
+
+        return events;
+    }
+}
+
+//==============================================================================
+TraceEvents::Scope::Scope(const char* nameToUse) : name(nameToUse)
+{
+    record(name, 'B');
+}
+
+TraceEvents::Scope::~Scope()
+{
+    record(name, 'E');
+}
+
+void TraceEvents::prepare()
+{
+    std::call_once(pool.allocated, [] { pool.rings.store(new Rings(), std::memory_order_release); });
+}
+
+void TraceEvents::releaseThread()
+{
+    if (tRing != nullptr)
+        tRing->owned.store(false, std::memory_order_release);
+
+    tRing = nullptr;
+    tExhausted = false;
+}
+
+juce::Result TraceEvents::writeChromeTrace(const juce::File& file)
+{
+    struct Track
+    {
+        int tid;
+        juce::String name;
+        std::vector<CopiedEvent> events;
+    };
+
+    std::vector<Track> tracks;
+    auto startTicks = std::numeric_limits<juce::int64>::max();
+    auto* rings = pool.rings.load(std::memory_order_acquire);
+
+    for (int i = 0; rings != nullptr && i < numRings; ++i)
+    {
+        auto& ring = (*rings)[size_t(i)];
+        auto events = copyEvents(ring);
+        if (events.empty())
+            continue;
+
+        juce::String name;
+        {
+            const ScopedNameLock nameLock(ring);
+            name = juce::String::fromUTF8(ring.threadName);
+        }
+
+        startTicks = juce::jmin(startTicks, events.front().ticks);
+        tracks.push_back({ i + 1, name, std::move(events) });
+    }
+
+    juce::TemporaryFile temp(file);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return juce::Result::fail("Couldn't write " + temp.getFile().getFullPathName());
+
+        const auto microsecondsPerTick = 1.0e6 / double(juce::Time::getHighResolutionTicksPerSecond());
+        auto separator = "\n";
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        for (const auto& track : tracks)
+        {
+            out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.tid
+                << ",\"args\":{\"name\":" << juce::JSON::toString(track.name) << "}}";
+            separator = ",\n";
+
+            // a lapped ring can start inside a scope, its end has nothing to close
+            int depth = 0;
+            for (const auto& event : track.events)
+            {
+                if (event.phase == 'E' && depth == 0)
+                    continue;
+                depth += event.phase == 'B' ? 1 : -1;
+
+                out << separator << "{\"name\":\"" << event.name << "\",\"ph\":\"" << juce::String::charToString(event.phase)
+                    << "\",\"pid\":1,\"tid\":" << track.tid
+                    << ",\"ts\":" << juce::String(double(event.ticks - startTicks) * microsecondsPerTick, 3) << "}";
+            }
+        }
+
+        out << "\n]}\n";
+        out.flush();
+
+        if (out.getStatus().failed())
+            return out.getStatus();
+    }
+
+    if (!temp.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Couldn't replace " + file.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+void TraceEvents::clear()
+{
+    auto* rings = pool.rings.load(std::memory_order_acquire);
+    if (rings == nullptr)
+        return;
+
+    for (auto& ring : *rings)
+        ring.clearedAt.store(ring.written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+#endif // EQ_TRACE_EVENTS
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    TraceEvents.h
+
+    Optional timeline instrumentation. Scopes record begin and end events
+    into a ring buffer owned by the recording thread, so the audio thread,
+    the analysers, the message thread and the GL thread never contend
+    with each other or with the reader. writeChromeTrace() turns whatever
+    the rings hold into a Chrome / Perfetto JSON trace.
+
+    The rings are allocated by prepare(), events recorded before it are
+    dropped. A thread claims a ring with its first event and keeps it until
+    it calls releaseThread().
+
+    Only compiled in when EQ_TRACE_EVENTS is set to 1; otherwise the
+    scopes are empty and the compiler drops them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef EQ_TRACE_EVENTS
+ #define EQ_TRACE_EVENTS 0
+#endif
+
+class TraceEvents
+{
+public:
+	//==============================================================================
+	static constexpr bool enabled = EQ_TRACE_EVENTS != 0;
+
+	/** Records a begin event now and the matching end event when it goes out
+		of scope. The name has to outlive the trace, use string literals.
+	*/
+	class Scope
+	{
+	public:
+#if EQ_TRACE_EVENTS
+		explicit Scope(const char* nameToUse);
+		~Scope();
+#else
+		explicit Scope(const char*) {}
+#endif
+
+	private:
+#if EQ_TRACE_EVENTS
+		const char* name;
+#endif
+
+		JUCE_DECLARE_NON_COPYABLE(Scope)
+	};
+
+#if EQ_TRACE_EVENTS
+	/** Allocates the rings once. Call from a thread that may allocate, before
+		the audio thread starts, so its first event doesn't allocate either.
+	*/
+	static void prepare();
+
+	/** Hands this thread's ring back so a thread started later can use it.
+		Call at the end of the run() of threads that record.
+	*/
+	static void releaseThread();
+
+	/** Writes every event still held by the rings as a Chrome trace. Can be
+		called from any thread while recording goes on.
+	*/
+	static juce::Result writeChromeTrace(const juce::File& file);
+
+	/** Forgets everything recorded so far. */
+	static void clear();
+#else
+	static void prepare() {}
+	static void releaseThread() {}
+	static juce::Result writeChromeTrace(const juce::File&) { return juce::Result::fail("This build has no trace events, define EQ_TRACE_EVENTS=1"); }
+	static void clear() {}
+#endif
+
+private:
+	//==============================================================================
+	TraceEvents() = delete;
+};
+
+#define EQ_TRACE_SCOPE(name) const TraceEvents::Scope JUCE_JOIN_MACRO(traceScope, __LINE__)(name)
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+    Hands whole values from one writer thread to one reader thread without
+    locks or allocation. The writer fills its own slot and swaps it with the
+    middle one, the reader swaps the middle one with its own when there is
+    something new, so neither ever sees a half written value and neither
+    waits for the other.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename Type>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	/** Writer side: fill this in completely, then publish() it. */
+	Type& getWriteBuffer()
+	{
+		return mSlots[size_t(mBack)];
+	}
+
+	void publish()
+	{
+		mBack = mMiddle.exchange(mBack | newDataBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	/** Reader side: takes the latest published value, returns false if nothing changed. */
+	bool pull()
+	{
+		if ((mMiddle.load(std::memory_order_relaxed) & newDataBit) == 0)
+			return false;
+
+		mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+
+	/** The value taken by the last pull(), stays put until the next one. */
+	const Type& read() const
+	{
+		return mSlots[size_t(mFront)];
+	}
+
+private:
+	static constexpr int indexMask = 3;
+	static constexpr int newDataBit = 4;
+
+	std::array<Type, 3> mSlots{};
+	int mFront = 0;
+	int mBack = 1;
+	std::atomic<int> mMiddle{ 2 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TripleBuffer)
+};
@@ -0,0 +1,334 @@
+/*
+  ==============================================================================
+
+    BenchCommand.cpp
+
+  ==============================================================================
+*/
+
+#include "BenchCommand.h"
+#include "HeadlessProcessor.h"
+
+namespace
+{
+    enum class BenchState
+    {
+        normal = 0,
+        solo,
+        bypassed
+    };
+
+    struct BenchCase
+    {
+        int blockSize = 512;
+        int numChannels = 2;
+        int numBands = 6;
+        int filterType = -1; // -1 keeps each band's own type
+        BenchState state = BenchState::normal;
+
+        /** Part of the output format: renaming a case breaks comparisons with older results. */
+        juce::String getName() const
+        {
+            static const char* stateNames[] = { "normal", "solo", "bypassed" };
+
+            const auto typeName = filterType < 0 ? juce::String("default")
+                                                 : Gainrev2AudioProcessor::getFilterTypeNames()[filterType].toLowerCase().removeCharacters(" ");
+
+            return "block-" + juce::String(blockSize)
+                + (numChannels == 1 ? "/mono" : "/stereo")
+                + "/bands-" + juce::String(numBands)
+                + "/" + typeName
+                + "/" + stateNames[int(state)];
+        }
+    };
+
+    struct BenchResult
+    {
+        BenchCase benchCase;
+        double nsPerSample = 0;
+        double nsPerSampleMin = 0;
+    };
+
+    std::vector<BenchCase> createCases()
+    {
+        std::vector<BenchCase> cases;
+        juce::StringArray names;
+
+        auto add = [&](const BenchCase& benchCase)
+        {
+            if (names.addIfNotAlreadyThere(benchCase.getName()))
+                cases.push_back(benchCase);
+        };
+
+        // block size against layout and load, with the bands as the default state sets them up
+        for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+            for (auto numChannels : { 1, 2 })
+                for (auto numBands : { 0, 1, 3, 6 })
+                    add({ blockSize, numChannels, numBands, -1, BenchState::normal });
+
+        // every filter type on all bands at a typical host block size
+        for (int type = Gainrev2AudioProcessor::HighPass; type < Gainrev2AudioProcessor::LastFilterID; ++type)
+            add({ 512, 2, 6, type, BenchState::normal });
+
+        for (auto numChannels : { 1, 2 })
+        {
+            add({ 512, numChannels, 6, -1, BenchState::solo });
+            add({ 512, numChannels, 6, -1, BenchState::bypassed });
+        }
+
+        return cases;
+    }
+
+    class Bench
+    {
+    public:
+        Bench(const juce::MemoryBlock& state, double secondsPerRun, int numRuns)
+            : mHost(state), mSecondsPerRun(secondsPerRun), mNumRuns(numRuns)
+        {
+            auto& parameters = mHost.getProcessor().getPluginState();
+            for (size_t i = 0; i < mHost.getProcessor().getNumBands(); ++i)
+                mDefaultTypes.push_back(int(parameters.getRawParameterValue(Gainrev2AudioProcessor::getTypeParamName(i))->load()));
+
+            // the same input for every case and every build
+            juce::Random random(0x5eed);
+            mSource.setSize(2, int(BenchCommand::sampleRate));
+            for (int channel = 0; channel < mSource.getNumChannels(); ++channel)
+                for (int i = 0; i < mSource.getNumSamples(); ++i)
+                    mSource.setSample(channel, i, random.nextFloat() - 0.5f);
+        }
+
+        BenchResult run(const BenchCase& benchCase)
+        {
+            setUp(benchCase);
+
+            juce::AudioBuffer<float> buffer(benchCase.numChannels, benchCase.blockSize);
+            int position = 0;
+
+            // each block gets fresh input, feeding the output back in would let boosts run away
+            auto processBlock = [&]
+            {
+                if (position + benchCase.blockSize > mSource.getNumSamples())
+                    position = 0;
+
+                for (int channel = 0; channel < benchCase.numChannels; ++channel)
+                    buffer.copyFrom(channel, 0, mSource, channel, position, benchCase.blockSize);
+                position += benchCase.blockSize;
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                if (benchCase.state == BenchState::bypassed)
+                    mHost.processBypassed(buffer);
+                else
+                    mHost.process(buffer);
+                return juce::Time::getHighResolutionTicks() - start;
+            };
+
+            for (int i = 0; i < juce::jmax(8, 8192 / benchCase.blockSize); ++i)
+                processBlock();
+
+            const auto ticksPerRun = juce::int64(mSecondsPerRun * double(juce::Time::getHighResolutionTicksPerSecond()));
+            std::vector<double> runs;
+
+            for (int run = 0; run < mNumRuns; ++run)
+            {
+                juce::int64 ticks = 0;
+                juce::int64 samples = 0;
+
+                while (ticks < ticksPerRun)
+                {
+                    ticks += processBlock();
+                    samples += benchCase.blockSize;
+                }
+
+                runs.push_back(juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / double(samples));
+            }
+
+            mHost.release();
+
+            std::sort(runs.begin(), runs.end());
+            return { benchCase, runs[runs.size() / 2], runs.front() };
+        }
+
+    private:
+        void setUp(const BenchCase& benchCase)
+        {
+            auto& processor = mHost.getProcessor();
+
+            for (size_t i = 0; i < processor.getNumBands(); ++i)
+            {
+                const auto type = benchCase.filterType < 0 ? mDefaultTypes[i] : benchCase.filterType;
+                mHost.setParameter(Gainrev2AudioProcessor::getTypeParamName(i), float(type));
+                mHost.setParameter(Gainrev2AudioProcessor::getActiveParamName(i), int(i) < benchCase.numBands ? 1.0f : 0.0f);
+            }
+
+            processor.setBandSolo(benchCase.state == BenchState::solo ? 0 : -1);
+
+            if (!mHost.prepare(benchCase.numChannels, BenchCommand::sampleRate, benchCase.blockSize))
+                juce::ConsoleApplication::fail("The processor doesn't support " + juce::String(benchCase.numChannels) + " channels");
+        }
+
+        HeadlessProcessor mHost;
+        std::vector<int> mDefaultTypes;
+        juce::AudioBuffer<float> mSource;
+
+        const double mSecondsPerRun;
+        const int mNumRuns;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Bench)
+    };
+
+    juce::var toJSON(const std::vector<BenchResult>& results, const juce::String& label, double secondsPerRun, int numRuns)
+    {
+        juce::DynamicObject::Ptr build = new juce::DynamicObject();
+        build->setProperty("label", label);
+#if JUCE_DEBUG
+        build->setProperty("configuration", "Debug");
+#else
+        build->setProperty("configuration", "Release");
+#endif
+        build->setProperty("compiled", juce::String(__DATE__) + " " + __TIME__);
+        build->setProperty("juce", juce::SystemStats::getJUCEVersion());
+
+        juce::DynamicObject::Ptr machine = new juce::DynamicObject();
+        machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+        machine->setProperty("cores", juce::SystemStats::getNumCpus());
+        machine->setProperty("mhz", juce::SystemStats::getCpuSpeedInMegahertz());
+
+        juce::Array<juce::var> cases;
+        for (const auto& result : results)
+        {
+            const auto& benchCase = result.benchCase;
+
+            juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+            entry->setProperty("name", benchCase.getName());
+            entry->setProperty("blockSize", benchCase.blockSize);
+            entry->setProperty("channels", benchCase.numChannels);
+            entry->setProperty("bands", benchCase.numBands);
+            entry->setProperty("filterType", benchCase.filterType < 0 ? juce::String("default")
+                                                                      : Gainrev2AudioProcessor::getFilterTypeNames()[benchCase.filterType]);
+            entry->setProperty("solo", benchCase.state == BenchState::solo);
+            entry->setProperty("bypassed", benchCase.state == BenchState::bypassed);
+            entry->setProperty("nsPerSample", result.nsPerSample);
+            entry->setProperty("nsPerSampleMin", result.nsPerSampleMin);
+            cases.add(juce::var(entry.get()));
+        }
+
+        juce::DynamicObject::Ptr root = new juce::DynamicObject();
+        root->setProperty("schema", BenchCommand::schemaVersion);
+        root->setProperty("build", juce::var(build.get()));
+        root->setProperty("machine", juce::var(machine.get()));
+        root->setProperty("sampleRate", BenchCommand::sampleRate);
+        root->setProperty("secondsPerRun", secondsPerRun);
+        root->setProperty("runs", numRuns);
+        root->setProperty("results", cases);
+
+        return juce::var(root.get());
+    }
+
+    /** Prints the change against an earlier result file and returns the worst slowdown in percent. */
+    double compare(const std::vector<BenchResult>& results, const juce::File& baselineFile)
+    {
+        const auto baseline = juce::JSON::parse(baselineFile);
+        if (int(baseline["schema"]) != BenchCommand::schemaVersion)
+            juce::ConsoleApplication::fail(baselineFile.getFullPathName() + " isn't a benchmark result this version can read");
+
+        std::map<juce::String, double> before;
+        if (auto* cases = baseline["results"].getArray())
+            for (const auto& entry : *cases)
+                before[entry["name"].toString()] = double(entry["nsPerSample"]);
+
+        std::cout << std::endl << "Compared with " << baselineFile.getFileName() << " (" << baseline["build"]["label"].toString() << ")" << std::endl;
+
+        double worst = 0;
+        for (const auto& result : results)
+        {
+            const auto name = result.benchCase.getName();
+            const auto found = before.find(name);
+            if (found == before.end() || found->second <= 0)
+            {
+                std::cout << name.paddedRight(' ', 44) << "   new" << std::endl;
+                continue;
+            }
+
+            const auto change = 100.0 * (result.nsPerSample / found->second - 1.0);
+            worst = juce::jmax(worst, change);
+            std::cout << name.paddedRight(' ', 44)
+                      << juce::String(found->second, 3).paddedLeft(' ', 10) << " -> " << juce::String(result.nsPerSample, 3).paddedLeft(' ', 10)
+                      << "  " << (change >= 0 ? "+" : "") << juce::String(change, 1) << "%" << std::endl;
+        }
+
+        return worst;
+    }
+
+    void runBench(const juce::ArgumentList& arguments)
+    {
+        auto args = arguments;
+        const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+        const auto stateFile = args.removeValueForOption("--state|-s");
+        const auto state = stateFile.isNotEmpty() ? HeadlessProcessor::loadState(workingDirectory.getChildFile(stateFile)) : juce::MemoryBlock();
+
+        const auto outputFile = args.removeValueForOption("--output|-o");
+        const auto baselineFile = args.removeValueForOption("--compare|-c");
+        const auto failAbove = args.removeValueForOption("--fail-above");
+        const auto filter = args.removeValueForOption("--filter");
+        const auto label = args.removeValueForOption("--label");
+
+        const auto time = args.removeValueForOption("--time");
+        const auto secondsPerRun = 0.001 * (time.isNotEmpty() ? time.getDoubleValue() : 100.0);
+        const auto runs = args.removeValueForOption("--runs");
+        const auto numRuns = runs.isNotEmpty() ? runs.getIntValue() : 5;
+
+        if (secondsPerRun <= 0 || numRuns < 1)
+            juce::ConsoleApplication::fail("--time and --runs have to be positive");
+
+        if (args.size() > 1)
+            juce::ConsoleApplication::fail("Unknown argument " + args[1].text);
+
+        if (baselineFile.isNotEmpty() && !workingDirectory.getChildFile(baselineFile).existsAsFile())
+            juce::ConsoleApplication::fail("No such baseline " + baselineFile);
+
+        Bench bench(state, secondsPerRun, numRuns);
+        std::vector<BenchResult> results;
+
+        for (const auto& benchCase : createCases())
+        {
+            const auto name = benchCase.getName();
+            if (filter.isNotEmpty() && !name.matchesWildcard(filter, true))
+                continue;
+
+            results.push_back(bench.run(benchCase));
+            std::cout << name.paddedRight(' ', 44) << juce::String(results.back().nsPerSample, 3).paddedLeft(' ', 10) << " ns/sample" << std::endl;
+        }
+
+        if (results.empty())
+            juce::ConsoleApplication::fail("No benchmark matches " + filter);
+
+        if (outputFile.isNotEmpty())
+        {
+            const auto file = workingDirectory.getChildFile(outputFile);
+            if (!file.replaceWithText(juce::JSON::toString(toJSON(results, label, secondsPerRun, numRuns))))
+                juce::ConsoleApplication::fail("Couldn't write " + file.getFullPathName());
+        }
+
+        if (baselineFile.isNotEmpty())
+        {
+            const auto worst = compare(results, workingDirectory.getChildFile(baselineFile));
+            if (failAbove.isNotEmpty() && worst > failAbove.getDoubleValue())
+                juce::ConsoleApplication::fail("Slower than the baseline by up to " + juce::String(worst, 1) + "%");
+        }
+    }
+}
+
+juce::ConsoleApplication::Command BenchCommand::create()
+{
+    return { "bench",
+             "bench [--output <file.json>] [--compare <baseline.json> [--fail-above <percent>]] [--filter <wildcard>] [--time <ms>] [--runs <n>] [--label <text>] [--state <file>]",
+             "Measures processBlock in ns/sample",
+             "Runs processBlock headlessly at 48 kHz for block sizes 16 to 4096, mono and stereo, 0 to 6 active\n"
+             "bands, every filter type and the solo and bypass states. Each case is timed for --time ms (100 by\n"
+             "default) --runs times (5) and the median is reported. Case names are stable across builds: write\n"
+             "one build's results with --output and check another against them with --compare; --fail-above\n"
+             "turns a slowdown beyond the given percentage into a non-zero exit code.",
+             runBench };
+}
@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+	BenchCommand.h
+
+	Micro-benchmark for processBlock. Sweeps block sizes, channel layouts,
+	the number of active bands, filter types and solo/bypass states, and
+	writes ns/sample per case to JSON under names that stay the same from
+	build to build, so two result files can be compared directly.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct BenchCommand
+{
+	static constexpr int schemaVersion = 1;
+	static constexpr double sampleRate = 48000.0;
+
+	static juce::ConsoleApplication::Command create();
+};
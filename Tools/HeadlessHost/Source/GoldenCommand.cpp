@@ -0,0 +1,459 @@
+/*
+  ==============================================================================
+
+    GoldenCommand.cpp
+
+  ==============================================================================
+*/
+
+#include "GoldenCommand.h"
+#include "HeadlessProcessor.h"
+
+namespace
+{
+    using Processor = Gainrev2AudioProcessor;
+
+    constexpr int blockSize = 512;
+    constexpr double sineAmplitude = 0.5;
+
+    /** Below this only staying below counts, the exact depth of a stop band is rounding noise. */
+    constexpr double floorDB = -60.0;
+
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    const double sineFrequencies[] = { 50.0, 200.0, 1000.0, 5000.0, 15000.0 };
+
+    bool usesQuality(int type)
+    {
+        return type == Processor::HighPass || type == Processor::LowShelf || type == Processor::BandPass
+            || type == Processor::AllPass || type == Processor::Notch || type == Processor::Peak
+            || type == Processor::HighShelf || type == Processor::LowPass;
+    }
+
+    bool usesGain(int type)
+    {
+        return type == Processor::LowShelf || type == Processor::Peak || type == Processor::HighShelf;
+    }
+
+    double toDB(double gain)
+    {
+        return juce::Decibels::gainToDecibels(gain, -200.0);
+    }
+
+    /** One bin of the DFT in double precision. Slower than an FFT for the few dozen bins we look at,
+        but the same on every platform, which a golden tolerance of 0.01 dB needs and the float FFT
+        backends don't promise. The phasor is reset from the exact angle every 1024 samples.
+    */
+    double getBinMagnitude(const std::vector<float>& data, int bin)
+    {
+        const auto length = juce::uint64(data.size());
+        const auto angle = [&](juce::uint64 position)
+        {
+            return -juce::MathConstants<double>::twoPi * double((juce::uint64(bin) * position) % length) / double(length);
+        };
+        const auto step = std::polar(1.0, angle(1));
+
+        std::complex<double> sum;
+        for (juce::uint64 start = 0; start < length; start += 1024)
+        {
+            auto phasor = std::polar(1.0, angle(start));
+            for (auto i = start; i < juce::jmin(length, start + 1024); ++i)
+            {
+                sum += double(data[size_t(i)]) * phasor;
+                phasor *= step;
+            }
+        }
+
+        return std::abs(sum);
+    }
+
+    struct GoldenCase
+    {
+        int type = Processor::NoFilter;
+        double sampleRate = 48000.0;
+        float frequency = 1000.0f;
+        float quality = 1.0f;
+        float gainDB = 0.0f;
+
+        /** Part of the golden file format: renaming a case orphans its stored response. */
+        juce::String getName() const
+        {
+            auto name = juce::String(juce::roundToInt(sampleRate)) + "/"
+                + Processor::getFilterTypeNames()[type].toLowerCase().removeCharacters(" ")
+                + "/f" + juce::String(juce::roundToInt(frequency));
+
+            if (usesQuality(type))
+                name << "/q" << juce::String(quality, 1);
+            if (usesGain(type))
+                name << "/g" << (gainDB > 0 ? "+" : "") << juce::roundToInt(gainDB);
+
+            return name;
+        }
+    };
+
+    std::vector<GoldenCase> createCases()
+    {
+        std::vector<GoldenCase> cases;
+
+        // the ends of every parameter range plus a typical value, on one band
+        for (auto sampleRate : sampleRates)
+            for (int type = Processor::NoFilter; type < Processor::LastFilterID; ++type)
+                for (auto frequency : { 20.0f, 1000.0f, 20000.0f })
+                    for (auto quality : usesQuality(type) ? std::vector<float>{ 0.1f, 1.0f, 10.0f } : std::vector<float>{ 1.0f })
+                        for (auto gainDB : usesGain(type) ? std::vector<float>{ -24.0f, 0.0f, 24.0f } : std::vector<float>{ 0.0f })
+                            if (type != Processor::NoFilter || frequency == 1000.0f)
+                                cases.push_back({ type, sampleRate, frequency, quality, gainDB });
+
+        return cases;
+    }
+
+    struct Response
+    {
+        std::vector<double> frequencies;
+        std::vector<double> measuredDB;
+        std::vector<double> referenceDB;
+        bool finite = true;
+    };
+
+    using GoldenResponses = std::map<juce::String, std::pair<std::vector<double>, std::vector<double>>>;
+
+    /** Describes the worst point outside the tolerance, or returns an empty string if there is none. */
+    juce::String compare(const juce::String& what, const std::vector<double>& frequencies,
+        const std::vector<double>& measuredDB, const std::vector<double>& expectedDB, double tolerance)
+    {
+        double worst = 0;
+        size_t worstIndex = 0;
+
+        for (size_t i = 0; i < frequencies.size(); ++i)
+        {
+            const auto error = expectedDB[i] < floorDB ? juce::jmax(0.0, measuredDB[i] - floorDB)
+                                                       : std::abs(measuredDB[i] - expectedDB[i]);
+            if (error > worst)
+            {
+                worst = error;
+                worstIndex = i;
+            }
+        }
+
+        if (worst <= tolerance)
+            return {};
+
+        return what + " off by " + juce::String(worst, 3) + " dB at " + juce::String(frequencies[worstIndex], 1) + " Hz ("
+            + juce::String(measuredDB[worstIndex], 3) + " instead of " + juce::String(expectedDB[worstIndex], 3) + " dB)";
+    }
+
+    class GoldenRunner
+    {
+    public:
+        GoldenRunner() = default;
+
+        /** Sets band 0 up for the case, switches the others off and returns the coefficients it should run. */
+        juce::dsp::IIR::Coefficients<float>::Ptr setUp(const GoldenCase& goldenCase)
+        {
+            auto& processor = mHost.getProcessor();
+
+            for (size_t i = 0; i < processor.getNumBands(); ++i)
+                mHost.setParameter(Processor::getActiveParamName(i), i == 0 ? 1.0f : 0.0f);
+
+            mHost.setParameter(Processor::paramOutput, 1.0f);
+            mHost.setParameter(Processor::getTypeParamName(0), float(goldenCase.type));
+            mHost.setParameter(Processor::getFrequencyParamName(0), goldenCase.frequency);
+            mHost.setParameter(Processor::getQualityParamName(0), goldenCase.quality);
+            mHost.setParameter(Processor::getGainParamName(0), juce::Decibels::decibelsToGain(goldenCase.gainDB));
+            processor.setBandSolo(-1);
+
+            restart(goldenCase.sampleRate);
+
+            // the reference uses what the parameters snapped to, not the requested values
+            mBand = *processor.getBand(0);
+            return Processor::makeCoefficients(mBand.type, goldenCase.sampleRate, mBand.frequency, mBand.quality, mBand.gain);
+        }
+
+        /** Magnitude of the impulse response at 1/6 octave steps, each rounded to the nearest DFT bin.
+
+            Only compared against a golden file, not against the design: with a 20 Hz band the float32
+            filter state moves notches and peaks around the band by up to 13 dB at 44.1 to 192 kHz,
+            and at 176.4 kHz a Q 0.1 low shelf's coefficients round to a pole on the unit circle.
+            No single tolerance separates that from a real regression.
+        */
+        Response measureImpulse(double sampleRate)
+        {
+            // about two seconds, long enough for a 20 Hz band with Q 10 to ring out far below the floor
+            const auto length = 1 << int(std::ceil(std::log2(sampleRate * 2.0)));
+            std::vector<float> measured(size_t(length), 0.0f);
+
+            Response response;
+            restart(sampleRate);
+
+            for (int position = 0; position < length; position += blockSize)
+            {
+                mBuffer.clear();
+                if (position == 0)
+                    mBuffer.setSample(0, 0, 1.0f);
+
+                mHost.process(mBuffer);
+                std::copy_n(mBuffer.getReadPointer(0), juce::jmin(blockSize, length - position), measured.data() + position);
+            }
+
+            response.finite = std::all_of(measured.begin(), measured.end(), [](float sample) { return std::isfinite(sample); });
+
+            const auto binWidth = sampleRate / length;
+            auto lastBin = -1;
+            for (int step = 0;; ++step)
+            {
+                const auto frequency = 20.0 * std::pow(2.0, step / 6.0);
+                if (frequency > 0.45 * sampleRate)
+                    break;
+
+                const auto bin = juce::roundToInt(frequency / binWidth);
+                if (bin == lastBin)
+                    continue;
+
+                lastBin = bin;
+                response.frequencies.push_back(bin * binWidth);
+                response.measuredDB.push_back(toDB(getBinMagnitude(measured, bin)));
+            }
+
+            return response;
+        }
+
+        /** Steady-state gain for a few sines, each correlated over a whole number of cycles once the band has settled.
+            They start at 50 Hz, above the low-frequency float32 errors measureImpulse() describes.
+        */
+        Response measureSines(double sampleRate, const juce::dsp::IIR::Coefficients<float>& reference)
+        {
+            // eight time constants of the band's slowest pole, by then the transient is below -70 dB;
+            // that's 2Q / w0 for a resonance and about 1 / (Q w0) once a low Q splits the poles
+            const auto quality = usesQuality(mBand.type) ? double(mBand.quality) : 0.5;
+            const auto timeConstant = juce::jmax(2.0 * quality, 1.0 / quality) / (juce::MathConstants<double>::twoPi * mBand.frequency);
+            const auto settleSeconds = juce::jmax(0.05, 8.0 * timeConstant);
+
+            Response response;
+
+            for (auto frequency : sineFrequencies)
+            {
+                if (frequency > 0.45 * sampleRate)
+                    continue;
+
+                restart(sampleRate);
+
+                const auto settle = int(settleSeconds * sampleRate);
+                const auto cycles = juce::jmax(1, int(0.1 * frequency));
+                const auto measure = juce::roundToInt(cycles * sampleRate / frequency);
+                const auto total = settle + measure;
+                const auto delta = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+                double sinSum = 0, cosSum = 0;
+                for (int position = 0; position < total; position += blockSize)
+                {
+                    const auto numSamples = juce::jmin(blockSize, total - position);
+                    juce::AudioBuffer<float> block(mBuffer.getArrayOfWritePointers(), 1, numSamples);
+
+                    for (int i = 0; i < numSamples; ++i)
+                        block.setSample(0, i, float(sineAmplitude * std::sin(delta * (position + i))));
+
+                    mHost.process(block);
+
+                    for (int i = juce::jmax(0, settle - position); i < numSamples; ++i)
+                    {
+                        const auto sample = double(block.getSample(0, i));
+                        response.finite = response.finite && std::isfinite(sample);
+                        sinSum += sample * std::sin(delta * (position + i));
+                        cosSum += sample * std::cos(delta * (position + i));
+                    }
+                }
+
+                const auto amplitude = 2.0 * std::sqrt(sinSum * sinSum + cosSum * cosSum) / measure;
+                response.frequencies.push_back(frequency);
+                response.measuredDB.push_back(toDB(amplitude / sineAmplitude));
+                response.referenceDB.push_back(toDB(reference.getMagnitudeForFrequency(frequency, sampleRate)));
+            }
+
+            return response;
+        }
+
+    private:
+        /** Preparing again clears the filter state between measurements. */
+        void restart(double sampleRate)
+        {
+            if (!mHost.prepare(1, sampleRate, blockSize))
+                juce::ConsoleApplication::fail("The processor doesn't accept a mono layout");
+        }
+
+        HeadlessProcessor mHost;
+        juce::AudioBuffer<float> mBuffer{ 1, blockSize };
+        Processor::Band mBand{ {}, {}, Processor::NoFilter, 1000.0f };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GoldenRunner)
+    };
+
+    //==============================================================================
+    juce::Array<juce::var> toVarArray(const std::vector<double>& values, bool round)
+    {
+        juce::Array<juce::var> array;
+        for (auto value : values)
+            array.add(round ? std::round(value * 1.0e4) / 1.0e4 : value);
+        return array;
+    }
+
+    std::vector<double> fromVarArray(const juce::var& values)
+    {
+        std::vector<double> result;
+        if (auto* array = values.getArray())
+            for (const auto& value : *array)
+                result.push_back(double(value));
+        return result;
+    }
+
+    GoldenResponses readGolden(const juce::File& file)
+    {
+        if (!file.existsAsFile())
+            juce::ConsoleApplication::fail("No such golden file " + file.getFullPathName());
+
+        const auto root = juce::JSON::parse(file);
+        if (int(root["schema"]) != GoldenCommand::schemaVersion)
+            juce::ConsoleApplication::fail(file.getFullPathName() + " isn't a golden file this version can read");
+
+        GoldenResponses responses;
+        if (auto* cases = root["cases"].getArray())
+            for (const auto& entry : *cases)
+                responses[entry["name"].toString()] = { fromVarArray(entry["frequencies"]), fromVarArray(entry["magnitudeDB"]) };
+
+        return responses;
+    }
+
+    void writeGolden(const juce::File& file, const std::vector<std::pair<juce::String, Response>>& measured)
+    {
+        juce::Array<juce::var> cases;
+        for (const auto& entry : measured)
+        {
+            juce::DynamicObject::Ptr object = new juce::DynamicObject();
+            object->setProperty("name", entry.first);
+            object->setProperty("frequencies", toVarArray(entry.second.frequencies, false));
+            object->setProperty("magnitudeDB", toVarArray(entry.second.measuredDB, true));
+            cases.add(juce::var(object.get()));
+        }
+
+        juce::DynamicObject::Ptr root = new juce::DynamicObject();
+        root->setProperty("schema", GoldenCommand::schemaVersion);
+        root->setProperty("juce", juce::SystemStats::getJUCEVersion());
+        root->setProperty("cases", cases);
+
+        if (!file.replaceWithText(juce::JSON::toString(juce::var(root.get()))))
+            juce::ConsoleApplication::fail("Couldn't write " + file.getFullPathName());
+    }
+
+    //==============================================================================
+    void runGolden(const juce::ArgumentList& arguments)
+    {
+        auto args = arguments;
+        const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+        const auto goldenText = args.removeValueForOption("--golden|-g");
+        const auto write = args.removeOptionIfFound("--write");
+        const auto filter = args.removeValueForOption("--filter");
+        const auto toleranceText = args.removeValueForOption("--tolerance");
+        const auto tolerance = toleranceText.isNotEmpty() ? toleranceText.getDoubleValue() : 0.1;
+        const auto goldenToleranceText = args.removeValueForOption("--golden-tolerance");
+        const auto goldenTolerance = goldenToleranceText.isNotEmpty() ? goldenToleranceText.getDoubleValue() : 0.01;
+        const auto withSines = !args.removeOptionIfFound("--no-sines");
+        const auto verbose = args.removeOptionIfFound("--verbose|-v");
+
+        if (args.size() > 1)
+            juce::ConsoleApplication::fail("Unknown argument " + args[1].text);
+        if (tolerance <= 0 || goldenTolerance <= 0)
+            juce::ConsoleApplication::fail("Tolerances have to be positive");
+        if (write && goldenText.isEmpty())
+            juce::ConsoleApplication::fail("--write needs --golden <file.json>");
+        if (write && !withSines)
+            juce::ConsoleApplication::fail("--write needs the sines, they are what vouches for the stored responses");
+
+        const auto goldenFile = goldenText.isNotEmpty() ? workingDirectory.getChildFile(goldenText) : juce::File();
+        const auto golden = goldenText.isNotEmpty() && !write ? readGolden(goldenFile) : GoldenResponses();
+
+        GoldenRunner runner;
+        std::vector<std::pair<juce::String, Response>> measured;
+        int numCases = 0, numFailed = 0;
+
+        for (const auto& goldenCase : createCases())
+        {
+            const auto name = goldenCase.getName();
+            if (filter.isNotEmpty() && !name.matchesWildcard(filter, true))
+                continue;
+
+            ++numCases;
+            const auto reference = runner.setUp(goldenCase);
+            const auto impulse = runner.measureImpulse(goldenCase.sampleRate);
+
+            juce::StringArray problems;
+            if (!impulse.finite)
+                problems.add("impulse response isn't finite");
+
+            if (withSines)
+            {
+                const auto sines = runner.measureSines(goldenCase.sampleRate, *reference);
+                if (!sines.finite)
+                    problems.add("sine response isn't finite");
+                problems.add(compare("sine gain", sines.frequencies, sines.measuredDB, sines.referenceDB, tolerance));
+            }
+
+            if (!golden.empty())
+            {
+                const auto stored = golden.find(name);
+                if (stored == golden.end())
+                    problems.add("not in the golden file, write a new one with --write");
+                else if (stored->second.first.size() != impulse.frequencies.size()
+                         || !std::equal(impulse.frequencies.begin(), impulse.frequencies.end(), stored->second.first.begin(),
+                                        [](double a, double b) { return std::abs(a - b) < 1.0e-6; }))
+                    problems.add("measured at different frequencies than the golden file");
+                else
+                    problems.add(compare("golden response", impulse.frequencies, impulse.measuredDB, stored->second.second, goldenTolerance));
+            }
+
+            problems.removeEmptyStrings();
+
+            if (!problems.isEmpty())
+            {
+                ++numFailed;
+                std::cout << "FAIL " << name << std::endl;
+                for (const auto& problem : problems)
+                    std::cout << "     " << problem << std::endl;
+            }
+            else if (verbose)
+            {
+                std::cout << "ok   " << name << std::endl;
+            }
+
+            if (write)
+                measured.emplace_back(name, impulse);
+        }
+
+        if (numCases == 0)
+            juce::ConsoleApplication::fail("No case matches " + filter);
+
+        std::cout << numCases - numFailed << " of " << numCases << " cases match" << std::endl;
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail(juce::String(numFailed) + " cases are outside the tolerance" + (write ? ", not writing a golden file" : ""));
+
+        if (write)
+        {
+            writeGolden(goldenFile, measured);
+            std::cout << "Wrote " << int(measured.size()) << " responses to " << goldenFile.getFullPathName() << std::endl;
+        }
+    }
+}
+
+juce::ConsoleApplication::Command GoldenCommand::create()
+{
+    return { "golden",
+             "golden [--golden <file.json> [--write]] [--tolerance <dB>] [--golden-tolerance <dB>] [--filter <wildcard>] [--no-sines] [--verbose]",
+             "Checks every filter type's frequency response against its design and a golden file",
+             "Sets a single band to every filter type at 44.1 to 192 kHz with the lowest, a typical and the\n"
+             "highest frequency, Q and gain, and measures its magnitude response twice. Stepped sines from\n"
+             "50 Hz up, once the band has settled, have to be within --tolerance (0.1 dB) of the design from\n"
+             "getMagnitudeForFrequency(). A two second impulse response at 1/6 octave steps is only compared\n"
+             "with --golden: it has to be within --golden-tolerance (0.01 dB) of the file, which --write fills\n"
+             "with this build's responses once its sines pass. Levels below -60 dB only have to stay below\n"
+             "-60 dB.",
+             runGolden };
+}
@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+	GoldenCommand.h
+
+	Frequency response regression test. Runs impulses and stepped sines
+	through a single band for every filter type, sample rates from 44.1 to
+	192 kHz and the extremes of each parameter, and checks the measured
+	magnitudes against the filter's own getMagnitudeForFrequencyArray()
+	and against a golden file written by an earlier, trusted build.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct GoldenCommand
+{
+	static constexpr int schemaVersion = 1;
+
+	static juce::ConsoleApplication::Command create();
+};
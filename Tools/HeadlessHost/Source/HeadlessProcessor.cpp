@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    HeadlessProcessor.cpp
+
+  ==============================================================================
+*/
+
+#include "HeadlessProcessor.h"
+
+HeadlessProcessor::HeadlessProcessor(const juce::MemoryBlock& state)
+{
+    if (state.getSize() > 0)
+        mProcessor.setStateInformation(state.getData(), int(state.getSize()));
+
+    // nothing is ever drawn here, so don't let a saved state start the overlay thread
+    mProcessor.setPhaseOverlay(false);
+    mProcessor.setGroupDelayOverlay(false);
+}
+
+HeadlessProcessor::~HeadlessProcessor()
+{
+    release();
+}
+
+bool HeadlessProcessor::prepare(int numChannels, double sampleRate, int maxBlockSize)
+{
+    release();
+
+    if (numChannels < 1 || numChannels > 2)
+        return false;
+
+    const auto channels = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channels);
+    layout.outputBuses.add(channels);
+
+    if (!mProcessor.setBusesLayout(layout))
+        return false;
+
+    mProcessor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+    mProcessor.prepareToPlay(sampleRate, maxBlockSize);
+    mMidi.ensureSize(256);
+    mPrepared = true;
+    return true;
+}
+
+void HeadlessProcessor::release()
+{
+    if (mPrepared)
+        mProcessor.releaseResources();
+
+    mPrepared = false;
+}
+
+void HeadlessProcessor::process(juce::AudioBuffer<float>& buffer)
+{
+    jassert(mPrepared);
+    jassert(buffer.getNumChannels() == mProcessor.getTotalNumOutputChannels());
+
+    // hosts hold the callback lock around processBlock, so the tools measure with it held too
+    const juce::ScopedLock callbackLock(mProcessor.getCallbackLock());
+    mMidi.clear();
+    mProcessor.processBlock(buffer, mMidi);
+}
+
+void HeadlessProcessor::processBypassed(juce::AudioBuffer<float>& buffer)
+{
+    jassert(mPrepared);
+
+    const juce::ScopedLock callbackLock(mProcessor.getCallbackLock());
+    mMidi.clear();
+    mProcessor.processBlockBypassed(buffer, mMidi);
+}
+
+void HeadlessProcessor::setParameter(const juce::String& parameterID, float value)
+{
+    auto* parameter = mProcessor.getPluginState().getParameter(parameterID);
+    jassert(parameter != nullptr);
+
+    if (parameter != nullptr)
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void HeadlessProcessor::automate(int parameterIndex, float normalisedValue)
+{
+    auto* parameter = mProcessor.getParameters()[parameterIndex];
+    jassert(parameter != nullptr);
+
+    if (parameter != nullptr)
+    {
+        parameter->setValue(normalisedValue);
+        parameter->sendValueChangedMessageToListeners(normalisedValue);
+    }
+}
+
+juce::MemoryBlock HeadlessProcessor::loadState(const juce::File& file)
+{
+    juce::MemoryBlock state;
+    if (!file.existsAsFile() || !file.loadFileAsData(state) || state.getSize() == 0)
+        juce::ConsoleApplication::fail("Couldn't read the state file " + file.getFullPathName());
+
+    // reject anything setStateInformation() would silently ignore
+    StateFormat::Contents contents;
+    const auto valid = StateFormat::isBinaryState(state.getData(), state.getSize())
+        ? StateFormat::read(state.getData(), state.getSize(), contents)
+        : juce::ValueTree::readFromData(state.getData(), state.getSize()).isValid();
+    if (!valid)
+        juce::ConsoleApplication::fail(file.getFullPathName() + " doesn't contain a saved plugin state");
+
+    return state;
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+	HeadlessProcessor.h
+
+	Hosts one instance of the EQ without an editor or audio device: restores
+	a saved state, sets the channel layout and sample rate for each piece of
+	work and calls processBlock the way a plugin host would.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+class HeadlessProcessor
+{
+public:
+	//==============================================================================
+	/** Creates the processor and restores state, which is a blob in the format
+		getStateInformation() writes. An empty block keeps the default bands.
+		Call on the message thread.
+	*/
+	explicit HeadlessProcessor(const juce::MemoryBlock& state = {});
+	~HeadlessProcessor();
+
+	Gainrev2AudioProcessor& getProcessor() { return mProcessor; }
+
+	/** Switches to a mono or stereo layout and prepares for playback.
+		Returns false if the processor doesn't support that many channels.
+	*/
+	bool prepare(int numChannels, double sampleRate, int maxBlockSize);
+	void release();
+
+	/** Processes the buffer in place under the callback lock, like a host would. */
+	void process(juce::AudioBuffer<float>& buffer);
+	/** Same for a host that has the plugin bypassed. */
+	void processBypassed(juce::AudioBuffer<float>& buffer);
+
+	/** Sets a parameter from its plain value and notifies the processor, like an automation write. */
+	void setParameter(const juce::String& parameterID, float value);
+
+	/** Applies automation the way plugin wrappers do, on the calling thread. */
+	void automate(int parameterIndex, float normalisedValue);
+
+	/** Reads a state file; throws through ConsoleApplication::fail() if it can't. */
+	static juce::MemoryBlock loadState(const juce::File& file);
+
+private:
+	//==============================================================================
+	Gainrev2AudioProcessor mProcessor;
+	juce::MidiBuffer mMidi;
+	bool mPrepared = false;
+
+	//==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HeadlessProcessor)
+};
@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Command line host for running the EQ without a DAW or an audio device.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RenderCommand.h"
+#include "BenchCommand.h"
+#include "RealtimeCheckCommand.h"
+#include "GoldenCommand.h"
+#include "StressCommand.h"
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // the processor's parameter state uses timers and listeners that expect a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("help|--help|-h", "Runs the Gain(rev2) EQ without a DAW.\nUsage: HeadlessHost <command> [options]", true);
+    app.addVersionCommand("--version", juce::String(ProjectInfo::projectName) + " " + ProjectInfo::versionString);
+
+    app.addCommand(RenderCommand::create());
+    app.addCommand(BenchCommand::create());
+    app.addCommand(RealtimeCheckCommand::create());
+    app.addCommand(GoldenCommand::create());
+    app.addCommand(StressCommand::create());
+
+    return app.findAndRunCommand(juce::ArgumentList(argc, argv), true);
+}
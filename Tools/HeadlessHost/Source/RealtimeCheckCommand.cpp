@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    RealtimeCheckCommand.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheckCommand.h"
+#include "HeadlessProcessor.h"
+#include "../../../Source/RealtimeCheck.h"
+#include "../../../Source/TraceEvents.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    class AudioThread : public juce::Thread
+    {
+    public:
+        AudioThread(HeadlessProcessor& host, int blockSize, double seconds, juce::int64 seed)
+            : juce::Thread("Audio"),
+            mHost(host),
+            mBuffer(2, blockSize),
+            mNumBlocks(juce::roundToInt(seconds * sampleRate / blockSize)),
+            mRandom(seed)
+        {
+        }
+
+        ~AudioThread() override
+        {
+            stopThread(-1);
+        }
+
+        void run() override
+        {
+            // also claims this thread's trace ring before any real-time scope
+            {
+                EQ_TRACE_SCOPE("Audio thread");
+                runBlocks();
+            }
+
+            TraceEvents::releaseThread();
+        }
+
+    private:
+        void runBlocks()
+        {
+            const auto& parameters = mHost.getProcessor().getParameters();
+            const auto blockMs = 1000.0 * mBuffer.getNumSamples() / sampleRate;
+            auto due = juce::Time::getMillisecondCounterHiRes();
+
+            for (int block = 0; block < mNumBlocks && !threadShouldExit(); ++block)
+            {
+                {
+                    // wrappers deliver automation on the audio thread before the block
+                    const RealtimeCheck::ScopedRealtime realtime;
+
+                    for (int i = mRandom.nextInt(3); --i >= 0;)
+                        mHost.automate(mRandom.nextInt(parameters.size()), mRandom.nextFloat());
+
+                    for (int channel = 0; channel < mBuffer.getNumChannels(); ++channel)
+                        for (int i = 0; i < mBuffer.getNumSamples(); ++i)
+                            mBuffer.setSample(channel, i, mRandom.nextFloat() - 0.5f);
+                }
+
+                mHost.process(mBuffer);
+
+                // paced like a device callback so the message thread gets to interleave
+                due += blockMs;
+                const auto wait = due - juce::Time::getMillisecondCounterHiRes();
+                if (wait >= 1.0)
+                    juce::Thread::sleep(int(wait));
+            }
+        }
+
+        HeadlessProcessor& mHost;
+        juce::AudioBuffer<float> mBuffer;
+        const int mNumBlocks;
+        juce::Random mRandom;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioThread)
+    };
+
+    /** One frame of what an open editor asks of the processor, plus the odd user edit. */
+    void simulateEditorFrame(Gainrev2AudioProcessor& processor, Gainrev2AudioProcessor::Generations& seen, juce::Random& random)
+    {
+        if (processor.getChangesSince(seen) != 0)
+            processor.updateResponses();
+
+        juce::Path path;
+        Polyline::Points points;
+        if (processor.checkForNewAnalyserData())
+        {
+            processor.swapAnalyserPlot(path, points, true);
+            processor.swapAnalyserPlot(path, points, false);
+        }
+
+        processor.getStereoReadout();
+
+        ResponseOverlays::Curves curves;
+        processor.getOverlayCurves(curves);
+
+        const auto& parameters = processor.getParameters();
+        if (random.nextInt(20) == 0)
+        {
+            auto* parameter = parameters[random.nextInt(parameters.size())];
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost(random.nextFloat());
+            parameter->endChangeGesture();
+        }
+
+        if (random.nextInt(200) == 0)
+            processor.setBandSolo(random.nextInt(int(processor.getNumBands()) + 1) - 1);
+        if (random.nextInt(300) == 0)
+            processor.setPhaseOverlay(!processor.getPhaseOverlay());
+        if (random.nextInt(300) == 0)
+            processor.setAnalyserMultiResolution(!processor.getAnalyserMultiResolution());
+    }
+
+    void runRealtimeCheck(const juce::ArgumentList& arguments)
+    {
+        if (!RealtimeCheck::enabled)
+            juce::ConsoleApplication::fail("This build has no real-time checks, use the Debug configuration or define EQ_REALTIME_CHECKS=1");
+
+        auto args = arguments;
+
+        const auto secondsText = args.removeValueForOption("--seconds");
+        const auto seconds = secondsText.isNotEmpty() ? secondsText.getDoubleValue() : 10.0;
+        const auto blockSizeText = args.removeValueForOption("--block-size|-b");
+        const auto blockSize = blockSizeText.isNotEmpty() ? blockSizeText.getIntValue() : 256;
+        const auto seedText = args.removeValueForOption("--seed");
+        const auto seed = seedText.isNotEmpty() ? seedText.getLargeIntValue() : juce::Time::currentTimeMillis();
+        const auto maxReportsText = args.removeValueForOption("--max-reports");
+        const auto maxReports = maxReportsText.isNotEmpty() ? maxReportsText.getIntValue() : 20;
+        const auto traceText = args.removeValueForOption("--trace");
+        const auto traceFile = traceText.isNotEmpty() ? juce::File::getCurrentWorkingDirectory().getChildFile(traceText) : juce::File();
+
+        if (seconds <= 0 || blockSize < 16 || blockSize > 8192)
+            juce::ConsoleApplication::fail("--seconds has to be positive and --block-size between 16 and 8192");
+        if (args.size() > 1)
+            juce::ConsoleApplication::fail("Unknown argument " + args[1].text);
+        if (traceFile != juce::File() && !TraceEvents::enabled)
+            juce::ConsoleApplication::fail("This build has no trace events, use the Debug configuration or define EQ_TRACE_EVENTS=1");
+
+        HeadlessProcessor host;
+        auto& processor = host.getProcessor();
+        if (!host.prepare(2, sampleRate, blockSize))
+            juce::ConsoleApplication::fail("The processor doesn't accept a stereo layout");
+
+        processor.setAnalysersActive(true);
+        processor.setAnalyserPlotBounds({ 0, 0, 1200, 600 }, 20.0f);
+
+        std::cout << "Checking " << seconds << " s of audio in blocks of " << blockSize << " (seed " << seed << ")" << std::endl;
+        RealtimeCheck::clearViolations();
+        TraceEvents::clear();
+
+        juce::Random random(seed + 1);
+        Gainrev2AudioProcessor::Generations seen{};
+
+        AudioThread audio(host, blockSize, seconds, seed);
+        audio.startThread(juce::Thread::realtimeAudioPriority);
+
+        while (audio.isThreadRunning())
+        {
+            simulateEditorFrame(processor, seen, random);
+            juce::Thread::sleep(16);
+        }
+
+        processor.setAnalysersActive(false);
+        host.release();
+
+        if (traceFile != juce::File())
+        {
+            const auto result = TraceEvents::writeChromeTrace(traceFile);
+            if (result.failed())
+                juce::ConsoleApplication::fail(result.getErrorMessage());
+
+            std::cout << "Wrote the timeline to " << traceFile.getFullPathName() << std::endl;
+        }
+
+        const auto violations = RealtimeCheck::getViolations();
+        if (violations.empty())
+        {
+            std::cout << "No allocations, locks or blocking calls on the audio thread" << std::endl;
+            return;
+        }
+
+        int total = 0;
+        for (const auto& violation : violations)
+            total += violation.count;
+
+        for (size_t i = 0; i < violations.size() && int(i) < maxReports; ++i)
+        {
+            std::cout << std::endl << violations[i].count << "x " << violations[i].what << std::endl
+                      << violations[i].stack << std::endl;
+        }
+
+        juce::ConsoleApplication::fail(juce::String(total) + " real-time violations from " + juce::String(int(violations.size())) + " call sites");
+    }
+}
+
+juce::ConsoleApplication::Command RealtimeCheckCommand::create()
+{
+    return { "rtcheck",
+             "rtcheck [--seconds <n>] [--block-size <n>] [--seed <n>] [--max-reports <n>] [--trace <file.json>]",
+             "Reports allocations, locks and blocking calls on the audio thread",
+             "Runs processBlock on a paced audio thread that also applies random host automation, while the\n"
+             "message thread polls the processor like an open editor and makes occasional edits. Everything\n"
+             "RealtimeCheck catches inside processBlock or the automation is grouped by call stack and printed,\n"
+             "most frequent first; any violation makes the command fail. Only available in builds with\n"
+             "EQ_REALTIME_CHECKS=1 (the Debug configuration); link with -rdynamic for symbol names on Linux.\n"
+             "--trace also writes the audio, analyser and editor timeline as a Chrome / Perfetto trace, which\n"
+             "needs EQ_TRACE_EVENTS=1 (also set in the Debug configuration).",
+             runRealtimeCheck };
+}
@@ -0,0 +1,21 @@
+/*
+  ==============================================================================
+
+	RealtimeCheckCommand.h
+
+	Drives the processor from a paced audio thread with host automation while
+	the message thread does what an open editor does, then reports every
+	allocation, lock and blocking call RealtimeCheck caught on the audio
+	thread. Needs a build with EQ_REALTIME_CHECKS=1.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct RealtimeCheckCommand
+{
+	static juce::ConsoleApplication::Command create();
+};
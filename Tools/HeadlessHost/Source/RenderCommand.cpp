@@ -0,0 +1,323 @@
+/*
+  ==============================================================================
+
+    RenderCommand.cpp
+
+  ==============================================================================
+*/
+
+#include "RenderCommand.h"
+#include "HeadlessProcessor.h"
+#include "../../../Source/TraceEvents.h"
+
+namespace
+{
+    struct RenderJob
+    {
+        juce::File input;
+        juce::File output;
+    };
+
+    struct RenderSettings
+    {
+        juce::MemoryBlock state;
+        juce::String formatExtension;
+        int blockSize = RenderCommand::defaultBlockSize;
+        bool overwrite = false;
+    };
+
+    /** The work shared by all workers; each one takes the next file until none are left. */
+    class RenderQueue
+    {
+    public:
+        RenderQueue(std::vector<RenderJob> jobsToRender, RenderSettings settingsToUse)
+            : jobs(std::move(jobsToRender)), settings(std::move(settingsToUse))
+        {
+        }
+
+        const RenderJob* next()
+        {
+            const auto index = mNext.fetch_add(1);
+            return index < jobs.size() ? &jobs[index] : nullptr;
+        }
+
+        void report(const RenderJob& job, const juce::String& error, double realtimeFactor)
+        {
+            const auto finished = ++mFinished;
+            const juce::ScopedLock outputLock(mOutputLock);
+
+            std::cout << "[" << finished << "/" << jobs.size() << "] " << job.input.getFileName();
+            if (error.isEmpty())
+            {
+                std::cout << " -> " << job.output.getFullPathName() << " (" << juce::String(realtimeFactor, 1) << "x realtime)" << std::endl;
+            }
+            else
+            {
+                std::cout << " failed: " << error << std::endl;
+                ++mFailed;
+            }
+        }
+
+        int getNumFailed() const { return mFailed.load(); }
+
+        const std::vector<RenderJob> jobs;
+        const RenderSettings settings;
+
+    private:
+        std::atomic<size_t> mNext{ 0 };
+        std::atomic<int> mFinished{ 0 };
+        std::atomic<int> mFailed{ 0 };
+        juce::CriticalSection mOutputLock;
+    };
+
+    class RenderWorker : public juce::Thread
+    {
+    public:
+        RenderWorker(RenderQueue& queue, int index)
+            : juce::Thread("Render worker " + juce::String(index)),
+            mQueue(queue),
+            mProcessor(queue.settings.state)
+        {
+            mFormats.registerBasicFormats();
+        }
+
+        ~RenderWorker() override
+        {
+            stopThread(-1);
+        }
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                const auto* job = mQueue.next();
+                if (job == nullptr)
+                    break;
+
+                juce::String error;
+                const auto started = juce::Time::getMillisecondCounterHiRes();
+                const auto seconds = render(*job, error);
+                const auto elapsed = 0.001 * (juce::Time::getMillisecondCounterHiRes() - started);
+
+                mQueue.report(*job, error, seconds / juce::jmax(elapsed, 0.001));
+            }
+
+            TraceEvents::releaseThread();
+        }
+
+    private:
+        /** Returns the length of the rendered audio in seconds, or sets error. */
+        double render(const RenderJob& job, juce::String& error)
+        {
+            const auto& settings = mQueue.settings;
+
+            std::unique_ptr<juce::AudioFormatReader> reader(mFormats.createReaderFor(job.input));
+            if (reader == nullptr)
+            {
+                error = "not a readable audio file";
+                return 0;
+            }
+
+            const auto numChannels = int(reader->numChannels);
+            const auto sampleRate = reader->sampleRate;
+            if (!mProcessor.prepare(numChannels, sampleRate, settings.blockSize))
+            {
+                error = "only mono and stereo files can be processed";
+                return 0;
+            }
+
+            auto* format = mFormats.findFormatForFileExtension(settings.formatExtension.isNotEmpty() ? settings.formatExtension
+                                                                                                     : job.input.getFileExtension());
+            if (format == nullptr || (numChannels == 1 && !format->canDoMono()) || (numChannels == 2 && !format->canDoStereo()))
+            {
+                error = "no writable output format for this file";
+                return 0;
+            }
+
+            if (job.output.exists() && !settings.overwrite)
+            {
+                error = job.output.getFullPathName() + " already exists, use --overwrite to replace it";
+                return 0;
+            }
+
+            // rendered into a temporary file so an interrupted batch never leaves truncated outputs
+            job.output.getParentDirectory().createDirectory();
+            juce::TemporaryFile temp(job.output);
+
+            auto stream = temp.getFile().createOutputStream();
+            if (stream == nullptr)
+            {
+                error = "can't write to " + job.output.getParentDirectory().getFullPathName();
+                return 0;
+            }
+
+            const auto bitDepths = format->getPossibleBitDepths();
+            const auto bitDepth = bitDepths.contains(int(reader->bitsPerSample)) || bitDepths.isEmpty() ? int(reader->bitsPerSample)
+                                                                                                         : bitDepths.getLast();
+
+            std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, juce::uint32(numChannels),
+                                                                                    bitDepth, reader->metadataValues, 0));
+            if (writer == nullptr)
+            {
+                error = format->getFormatName() + " can't store " + juce::String(bitDepth) + " bit audio at " + juce::String(sampleRate) + " Hz";
+                return 0;
+            }
+            stream.release(); // the writer owns it now
+
+            mBuffer.setSize(numChannels, settings.blockSize, false, false, true);
+            const auto length = reader->lengthInSamples;
+
+            for (juce::int64 position = 0; position < length; position += settings.blockSize)
+            {
+                if (threadShouldExit())
+                {
+                    error = "cancelled";
+                    return 0;
+                }
+
+                const auto numSamples = int(juce::jmin(juce::int64(settings.blockSize), length - position));
+                mBuffer.setSize(numChannels, numSamples, false, false, true);
+
+                reader->read(&mBuffer, 0, numSamples, position, true, numChannels > 1);
+                mProcessor.process(mBuffer);
+
+                if (!writer->writeFromAudioSampleBuffer(mBuffer, 0, numSamples))
+                {
+                    error = "write failed";
+                    return 0;
+                }
+            }
+
+            writer.reset();
+            mProcessor.release();
+
+            if (!temp.overwriteTargetFileWithTemporary())
+            {
+                error = "couldn't replace " + job.output.getFullPathName();
+                return 0;
+            }
+
+            return double(length) / sampleRate;
+        }
+
+        RenderQueue& mQueue;
+        HeadlessProcessor mProcessor;
+        juce::AudioFormatManager mFormats;
+        juce::AudioBuffer<float> mBuffer;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderWorker)
+    };
+
+    std::vector<RenderJob> collectJobs(const juce::ArgumentList& args, const juce::File& outputFolder, const juce::String& formatExtension)
+    {
+        std::vector<RenderJob> jobs;
+
+        auto addJob = [&](const juce::File& input, const juce::String& relativePath)
+        {
+            auto output = outputFolder.getChildFile(relativePath);
+            if (formatExtension.isNotEmpty())
+                output = output.withFileExtension(formatExtension);
+
+            jobs.push_back({ input, output });
+        };
+
+        // index 0 is the command itself
+        for (int i = 1; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+            if (arg.isOption())
+                juce::ConsoleApplication::fail("Unknown option " + arg.text);
+
+            const auto input = arg.resolveAsFile();
+            if (input.isDirectory())
+            {
+                // folders keep their layout under the output folder, so equal names don't collide
+                for (const auto& file : input.findChildFiles(juce::File::findFiles, true, "*.wav;*.flac;*.aif;*.aiff"))
+                    if (!file.isAChildOf(outputFolder))
+                        addJob(file, file.getRelativePathFrom(input));
+            }
+            else if (input.existsAsFile())
+            {
+                addJob(input, input.getFileName());
+            }
+            else
+            {
+                juce::ConsoleApplication::fail("No such file or folder: " + arg.text);
+            }
+        }
+
+        return jobs;
+    }
+
+    void runRender(const juce::ArgumentList& arguments)
+    {
+        auto args = arguments;
+        RenderSettings settings;
+
+        const auto stateFile = args.removeValueForOption("--state|-s");
+        if (stateFile.isEmpty())
+            juce::ConsoleApplication::fail("Missing --state, the plugin state to render with");
+        settings.state = HeadlessProcessor::loadState(juce::File::getCurrentWorkingDirectory().getChildFile(stateFile));
+
+        const auto outputPath = args.removeValueForOption("--output|-o");
+        if (outputPath.isEmpty())
+            juce::ConsoleApplication::fail("Missing --output, the folder to render into");
+        const auto outputFolder = juce::File::getCurrentWorkingDirectory().getChildFile(outputPath);
+
+        const auto format = args.removeValueForOption("--format|-f").toLowerCase();
+        if (format.isNotEmpty())
+        {
+            if (!juce::StringArray{ "wav", "flac", "aiff" }.contains(format))
+                juce::ConsoleApplication::fail("Unsupported output format " + format + ", use wav, flac or aiff");
+            settings.formatExtension = "." + format;
+        }
+
+        const auto blockSize = args.removeValueForOption("--block-size|-b");
+        if (blockSize.isNotEmpty())
+            settings.blockSize = blockSize.getIntValue();
+        if (settings.blockSize < 16 || settings.blockSize > 65536)
+            juce::ConsoleApplication::fail("The block size has to be between 16 and 65536 samples");
+
+        const auto threads = args.removeValueForOption("--threads|-j");
+        auto numThreads = threads.isNotEmpty() ? threads.getIntValue() : juce::SystemStats::getNumCpus();
+
+        settings.overwrite = args.removeOptionIfFound("--overwrite");
+
+        auto jobs = collectJobs(args, outputFolder, settings.formatExtension);
+        if (jobs.empty())
+            juce::ConsoleApplication::fail("Nothing to render");
+
+        if (!outputFolder.createDirectory())
+            juce::ConsoleApplication::fail("Can't create " + outputFolder.getFullPathName());
+
+        numThreads = juce::jlimit(1, int(jobs.size()), numThreads);
+        RenderQueue queue(std::move(jobs), std::move(settings));
+
+        // processors are created here on the message thread, then each worker only uses its own
+        juce::OwnedArray<RenderWorker> workers;
+        for (int i = 0; i < numThreads; ++i)
+            workers.add(new RenderWorker(queue, i));
+
+        std::cout << "Rendering " << queue.jobs.size() << " files on " << numThreads << " threads" << std::endl;
+
+        for (auto* worker : workers)
+            worker->startThread();
+        for (auto* worker : workers)
+            worker->waitForThreadToExit(-1);
+
+        if (queue.getNumFailed() > 0)
+            juce::ConsoleApplication::fail(juce::String(queue.getNumFailed()) + " of " + juce::String(queue.jobs.size()) + " files failed");
+    }
+}
+
+juce::ConsoleApplication::Command RenderCommand::create()
+{
+    return { "render",
+             "render --state <file> --output <folder> [--format wav|flac|aiff] [--block-size <n>] [--threads <n>] [--overwrite] <files or folders...>",
+             "Renders audio files through the EQ offline",
+             "Streams each file through processBlock with the plugin state saved in --state, which is the blob\n"
+             "getStateInformation() writes. Folders are searched recursively for WAV, FLAC and AIFF files and\n"
+             "keep their layout under the output folder. Files are spread over --threads workers (one per core\n"
+             "by default), each with its own processor instance, and keep their format unless --format is given.",
+             runRender };
+}
@@ -0,0 +1,22 @@
+/*
+  ==============================================================================
+
+	RenderCommand.h
+
+	Offline batch rendering: streams WAV, FLAC and AIFF files through the EQ
+	with a saved plugin state. Files are spread over worker threads, each of
+	which owns its own processor instance.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct RenderCommand
+{
+	static constexpr int defaultBlockSize = 8192;
+
+	static juce::ConsoleApplication::Command create();
+};
@@ -0,0 +1,392 @@
+/*
+  ==============================================================================
+
+    StressCommand.cpp
+
+  ==============================================================================
+*/
+
+#include "StressCommand.h"
+#include "HeadlessProcessor.h"
+#include "../../../Source/TraceEvents.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    /** Written by the audio thread, read once it has stopped. */
+    struct AudioStats
+    {
+        int numBlocks = 0;
+        int numOverBudget = 0;
+        double maxLatencyMs = 0;
+        juce::int64 numNonFinite = 0;
+        juce::int64 numDenormals = 0;
+        juce::int64 numJumps = 0;
+        double maxJump = 0;
+        int firstBadBlock = -1;
+    };
+
+    class AudioThread : public juce::Thread
+    {
+    public:
+        AudioThread(HeadlessProcessor& host, int blockSize, double seconds, double jumpThreshold)
+            : juce::Thread("Audio"),
+            mHost(host),
+            mBuffer(2, blockSize),
+            mNumBlocks(juce::roundToInt(seconds * sampleRate / blockSize)),
+            mJumpThreshold(jumpThreshold)
+        {
+        }
+
+        ~AudioThread() override
+        {
+            stopThread(-1);
+        }
+
+        const AudioStats& getStats() const { return mStats; }
+
+        void run() override
+        {
+            const auto blockMs = 1000.0 * mBuffer.getNumSamples() / sampleRate;
+            auto due = juce::Time::getMillisecondCounterHiRes();
+
+            for (int block = 0; block < mNumBlocks && !threadShouldExit(); ++block)
+            {
+                fillInput();
+
+                // includes waiting for the callback lock, as a host callback would
+                const auto start = juce::Time::getMillisecondCounterHiRes();
+                mHost.process(mBuffer);
+                const auto latency = juce::Time::getMillisecondCounterHiRes() - start;
+
+                ++mStats.numBlocks;
+                mStats.maxLatencyMs = juce::jmax(mStats.maxLatencyMs, latency);
+                if (latency > blockMs)
+                    ++mStats.numOverBudget;
+
+                checkOutput(block);
+
+                due += blockMs;
+                const auto wait = due - juce::Time::getMillisecondCounterHiRes();
+                if (wait >= 1.0)
+                    juce::Thread::sleep(int(wait));
+            }
+
+            TraceEvents::releaseThread();
+        }
+
+    private:
+        /** Two quiet tones: smooth enough that any jump in the output comes from the processor. */
+        void fillInput()
+        {
+            const auto delta1 = juce::MathConstants<double>::twoPi * 110.0 / sampleRate;
+            const auto delta2 = juce::MathConstants<double>::twoPi * 1234.0 / sampleRate;
+
+            for (int i = 0; i < mBuffer.getNumSamples(); ++i)
+            {
+                const auto sample = float(0.25 * std::sin(mPhase1) + 0.1 * std::sin(mPhase2));
+                mPhase1 = std::fmod(mPhase1 + delta1, juce::MathConstants<double>::twoPi);
+                mPhase2 = std::fmod(mPhase2 + delta2, juce::MathConstants<double>::twoPi);
+
+                for (int channel = 0; channel < mBuffer.getNumChannels(); ++channel)
+                    mBuffer.setSample(channel, i, sample);
+            }
+        }
+
+        /** The second difference of a steady tone is a small fraction of its level, a click is not. */
+        void checkOutput(int block)
+        {
+            auto bad = false;
+
+            for (int channel = 0; channel < mBuffer.getNumChannels(); ++channel)
+            {
+                auto& history = mHistory[size_t(channel)];
+                const auto* data = mBuffer.getReadPointer(channel);
+
+                for (int i = 0; i < mBuffer.getNumSamples(); ++i)
+                {
+                    const auto sample = data[i];
+                    if (!std::isfinite(sample))
+                    {
+                        ++mStats.numNonFinite;
+                        bad = true;
+                        continue;
+                    }
+
+                    if (sample != 0.0f && std::abs(sample) < std::numeric_limits<float>::min())
+                    {
+                        ++mStats.numDenormals;
+                        bad = true;
+                    }
+
+                    history.envelope = juce::jmax(double(std::abs(sample)), history.envelope * 0.9995);
+                    const auto jump = std::abs(sample - 2.0 * history.previous[0] + history.previous[1]) / juce::jmax(history.envelope, 1.0e-3);
+                    if (history.valid >= 2)
+                    {
+                        mStats.maxJump = juce::jmax(mStats.maxJump, jump);
+                        if (jump > mJumpThreshold)
+                            ++mStats.numJumps;
+                    }
+
+                    history.previous[1] = history.previous[0];
+                    history.previous[0] = sample;
+                    history.valid = juce::jmin(2, history.valid + 1);
+                }
+            }
+
+            if (bad && mStats.firstBadBlock < 0)
+                mStats.firstBadBlock = block;
+        }
+
+        struct History
+        {
+            std::array<double, 2> previous{};
+            double envelope = 0;
+            int valid = 0;
+        };
+
+        HeadlessProcessor& mHost;
+        juce::AudioBuffer<float> mBuffer;
+        const int mNumBlocks;
+        const double mJumpThreshold;
+
+        double mPhase1 = 0, mPhase2 = 0;
+        std::array<History, 2> mHistory;
+        AudioStats mStats;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioThread)
+    };
+
+    /** Calls step over and over with short random pauses until stopped. */
+    class StressThread : public juce::Thread
+    {
+    public:
+        StressThread(const juce::String& name, juce::int64 seed, int maxPauseMs, std::function<void(juce::Random&)> stepToRun)
+            : juce::Thread(name), mRandom(seed), mMaxPauseMs(maxPauseMs), mStep(std::move(stepToRun))
+        {
+        }
+
+        ~StressThread() override
+        {
+            stopThread(-1);
+        }
+
+        int getNumSteps() const { return mNumSteps.load(); }
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                mStep(mRandom);
+                ++mNumSteps;
+
+                const auto pause = mRandom.nextInt(mMaxPauseMs + 1);
+                if (pause > 0)
+                    wait(pause);
+            }
+
+            TraceEvents::releaseThread();
+        }
+
+    private:
+        juce::Random mRandom;
+        const int mMaxPauseMs;
+        std::function<void(juce::Random&)> mStep;
+        std::atomic<int> mNumSteps{ 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StressThread)
+    };
+
+    /** Opens, paints and closes the editor on the message thread, and ends the dispatch loop once the audio is done. */
+    class EditorCycler : private juce::Timer
+    {
+    public:
+        EditorCycler(Gainrev2AudioProcessor& processor, int cycleMs, juce::int64 seed, std::function<bool()> isDone)
+            : mProcessor(processor), mCycleMs(cycleMs), mRandom(seed), mIsDone(std::move(isDone))
+        {
+            startTimer(30);
+        }
+
+        ~EditorCycler() override
+        {
+            stopTimer();
+            mEditor.reset();
+        }
+
+        int getNumCycles() const { return mNumCycles; }
+        int getNumPaints() const { return mNumPaints; }
+
+    private:
+        void timerCallback() override
+        {
+            if (mIsDone())
+            {
+                stopTimer();
+                mEditor.reset();
+                juce::MessageManager::getInstance()->stopDispatchLoop();
+                return;
+            }
+
+            const auto now = juce::Time::getMillisecondCounter();
+            if (mCycleMs > 0 && now >= mNextToggle)
+            {
+                if (mEditor != nullptr)
+                {
+                    mEditor.reset();
+                    ++mNumCycles;
+                }
+                else
+                {
+                    mEditor.reset(mProcessor.createEditorIfNeeded());
+                }
+
+                mNextToggle = now + juce::uint32(mCycleMs / 2 + mRandom.nextInt(mCycleMs + 1));
+            }
+
+            // there's no window, so paint the way a host's would
+            if (mEditor != nullptr)
+            {
+                mEditor->createComponentSnapshot(mEditor->getLocalBounds());
+                ++mNumPaints;
+            }
+        }
+
+        Gainrev2AudioProcessor& mProcessor;
+        const int mCycleMs;
+        juce::Random mRandom;
+        std::function<bool()> mIsDone;
+
+        std::unique_ptr<juce::AudioProcessorEditor> mEditor;
+        juce::uint32 mNextToggle = 0;
+        int mNumCycles = 0;
+        int mNumPaints = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EditorCycler)
+    };
+
+    void runStress(const juce::ArgumentList& arguments)
+    {
+        auto args = arguments;
+
+        const auto secondsText = args.removeValueForOption("--seconds");
+        const auto seconds = secondsText.isNotEmpty() ? secondsText.getDoubleValue() : 30.0;
+        const auto blockSizeText = args.removeValueForOption("--block-size|-b");
+        const auto blockSize = blockSizeText.isNotEmpty() ? blockSizeText.getIntValue() : 256;
+        const auto seedText = args.removeValueForOption("--seed");
+        const auto seed = seedText.isNotEmpty() ? seedText.getLargeIntValue() : juce::Time::currentTimeMillis();
+        const auto editorCycleText = args.removeValueForOption("--editor-cycle");
+        const auto editorCycleMs = editorCycleText.isNotEmpty() ? editorCycleText.getIntValue() : 500;
+        const auto jumpText = args.removeValueForOption("--jump-threshold");
+        const auto jumpThreshold = jumpText.isNotEmpty() ? jumpText.getDoubleValue() : 0.5;
+        const auto maxLatencyText = args.removeValueForOption("--max-latency");
+        const auto maxJumpsText = args.removeValueForOption("--max-jumps");
+
+        if (seconds <= 0 || blockSize < 16 || blockSize > 8192)
+            juce::ConsoleApplication::fail("--seconds has to be positive and --block-size between 16 and 8192");
+        if (editorCycleMs < 0 || jumpThreshold <= 0)
+            juce::ConsoleApplication::fail("--editor-cycle can't be negative and --jump-threshold has to be positive");
+        if (args.size() > 1)
+            juce::ConsoleApplication::fail("Unknown argument " + args[1].text);
+
+        HeadlessProcessor host;
+        auto& processor = host.getProcessor();
+        if (!host.prepare(2, sampleRate, blockSize))
+            juce::ConsoleApplication::fail("The processor doesn't accept a stereo layout");
+
+        std::cout << "Stressing " << seconds << " s of audio in blocks of " << blockSize << " (seed " << seed << ")" << std::endl;
+
+        AudioThread audio(host, blockSize, seconds, jumpThreshold);
+
+        const auto& parameters = processor.getParameters();
+        auto automate = [&parameters](juce::Random& random)
+        {
+            auto* parameter = parameters[random.nextInt(parameters.size())];
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost(random.nextFloat());
+            parameter->endChangeGesture();
+        };
+
+        StressThread automation1("Automation 1", seed + 1, 2, automate);
+        StressThread automation2("Automation 2", seed + 2, 2, automate);
+
+        StressThread solo("Solo", seed + 3, 10, [&processor](juce::Random& random)
+        {
+            processor.setBandSolo(random.nextInt(int(processor.getNumBands()) + 1) - 1);
+        });
+
+        // restores states this run has seen before, so every restore is a valid one
+        std::vector<juce::MemoryBlock> states;
+        StressThread state("State", seed + 4, 50, [&processor, &states](juce::Random& random)
+        {
+            if (states.empty() || random.nextBool())
+            {
+                juce::MemoryBlock saved;
+                processor.getStateInformation(saved);
+                if (states.size() < 8)
+                    states.push_back(std::move(saved));
+                else
+                    states[size_t(random.nextInt(int(states.size())))] = std::move(saved);
+            }
+            else
+            {
+                const auto& saved = states[size_t(random.nextInt(int(states.size())))];
+                processor.setStateInformation(saved.getData(), int(saved.getSize()));
+            }
+        });
+
+        audio.startThread(juce::Thread::realtimeAudioPriority);
+        for (auto* thread : { &automation1, &automation2, &solo, &state })
+            thread->startThread();
+
+        {
+            EditorCycler editor(processor, editorCycleMs, seed + 5, [&audio] { return !audio.isThreadRunning(); });
+            juce::MessageManager::getInstance()->runDispatchLoop();
+
+            std::cout << "Editor opened and closed " << editor.getNumCycles() << " times, painted " << editor.getNumPaints() << " times" << std::endl;
+        }
+
+        for (auto* thread : { &automation1, &automation2, &solo, &state })
+            thread->stopThread(5000);
+
+        host.release();
+
+        const auto& stats = audio.getStats();
+        const auto budgetMs = 1000.0 * blockSize / sampleRate;
+
+        std::cout << automation1.getNumSteps() + automation2.getNumSteps() << " parameter changes, "
+                  << solo.getNumSteps() << " solo changes, " << state.getNumSteps() << " state saves and restores" << std::endl
+                  << stats.numBlocks << " blocks, longest callback " << juce::String(stats.maxLatencyMs, 3) << " ms of "
+                  << juce::String(budgetMs, 3) << " ms budget, " << stats.numOverBudget << " over budget" << std::endl
+                  << stats.numNonFinite << " non-finite and " << stats.numDenormals << " denormal output samples" << std::endl
+                  << stats.numJumps << " jumps above " << jumpThreshold << ", largest " << juce::String(stats.maxJump, 3) << std::endl;
+
+        juce::StringArray failures;
+        if (stats.numNonFinite > 0 || stats.numDenormals > 0)
+            failures.add("bad output from block " + juce::String(stats.firstBadBlock) + " on");
+        if (maxLatencyText.isNotEmpty() && stats.maxLatencyMs > maxLatencyText.getDoubleValue())
+            failures.add("a callback took longer than " + maxLatencyText + " ms");
+        if (maxJumpsText.isNotEmpty() && stats.numJumps > maxJumpsText.getLargeIntValue())
+            failures.add("more than " + maxJumpsText + " jumps");
+
+        if (!failures.isEmpty())
+            juce::ConsoleApplication::fail("Failed with seed " + juce::String(seed) + ": " + failures.joinIntoString(", "));
+    }
+}
+
+juce::ConsoleApplication::Command StressCommand::create()
+{
+    return { "stress",
+             "stress [--seconds <n>] [--block-size <n>] [--seed <n>] [--editor-cycle <ms>] [--jump-threshold <ratio>] [--max-latency <ms>] [--max-jumps <n>]",
+             "Hammers the processor from several threads while checking the audio",
+             "Runs processBlock on a paced audio thread at 48 kHz on a two tone signal. Meanwhile two threads\n"
+             "make random setValueNotifyingHost() calls, one changes the solo band, one saves and restores\n"
+             "states, and the message thread opens, paints and closes the editor about every --editor-cycle ms\n"
+             "(500, 0 keeps it closed). Reports the longest callback including waits for the callback lock,\n"
+             "non-finite and denormal output, and jumps: second differences larger than --jump-threshold (0.5)\n"
+             "times the recent output level. Bad output always fails; --max-latency and --max-jumps make those\n"
+             "fail too. Crashes end the run, the seed printed first reproduces the same random choices. For\n"
+             "data races build the Release configuration with CXXFLAGS=-fsanitize=thread LDFLAGS=-fsanitize=thread\n"
+             "(the Debug configuration's real-time checks interpose the same functions ThreadSanitizer does).",
+             runStress };
+}
@@ -0,0 +1,23 @@
+/*
+  ==============================================================================
+
+	StressCommand.h
+
+	Runs processBlock on a paced audio thread while other threads throw
+	random automation, solo changes and state restores at the processor and
+	the message thread keeps opening, painting and closing the editor.
+	Reports the longest callback, non-finite and denormal output and
+	discontinuities. Build it with -fsanitize=thread to catch the races
+	this provokes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct StressCommand
+{
+	static juce::ConsoleApplication::Command create();
+};